@@ -0,0 +1,135 @@
+#include "ai_player.h"
+#include "perfect_play.h"
+
+using namespace std;
+
+const char* difficultyName(Difficulty difficulty) {
+    switch (difficulty) {
+        case Difficulty::EASY: return "easy";
+        case Difficulty::MEDIUM: return "medium";
+        case Difficulty::HARD: return "hard";
+        case Difficulty::MONTE_CARLO: return "mcts";
+    }
+    return "?";
+}
+
+bool parseDifficulty(const string& name, Difficulty& difficulty) {
+    const Difficulty all[] = {Difficulty::EASY, Difficulty::MEDIUM, Difficulty::HARD, Difficulty::MONTE_CARLO};
+    for (int i = 0; i < 4; i++) {
+        if (name == difficultyName(all[i])) {
+            difficulty = all[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+AIPlayer::AIPlayer(const BoardGeometry& geometry, uint64_t seed)
+    : shape(geometry), engine(geometry), monteCarlo(geometry), random(seed | 1) {
+}
+
+// Pick a move the way the given difficulty plays
+AIMove AIPlayer::chooseMove(const GridPosition& position, char player, Difficulty difficulty,
+                            const AISettings& settings) {
+    AIMove move = {-1, 0, 0, 0, 0, 0};
+    char opponent = player == 'X' ? 'O' : 'X';
+
+    switch (difficulty) {
+        case Difficulty::EASY:
+            // 70% random moves, 30% smart moves
+            if (nextRandom(10) < 7) {
+                move.cell = randomMove(position);
+            } else {
+                bestMove(position, player, settings, move);
+            }
+            break;
+
+        case Difficulty::MEDIUM:
+            // A learned table if there is one for this board
+            if (settings.policy && settings.policy->loaded() && PolicyTable::covers(shape)) {
+                double uniform = nextRandom(1 << 30) / static_cast<double>(1 << 30);
+                move.cell = settings.policy->chooseMove(position.cells(player), position.cells(opponent),
+                                                        settings.policyStrength, uniform);
+                break;
+            }
+            // Otherwise try to win, then block, then make a good move
+            move.cell = winningMove(position, player);
+            if (move.cell == -1) {
+                move.cell = winningMove(position, opponent); // Block
+                if (move.cell == -1) {
+                    bestMove(position, player, settings, move);
+                }
+            }
+            break;
+
+        case Difficulty::HARD:
+            // Always the best move
+            bestMove(position, player, settings, move);
+            break;
+
+        case Difficulty::MONTE_CARLO: {
+            // Tree search over random playouts, on any board
+            PlayoutLimits limits;
+            limits.playouts = settings.playouts;
+            limits.threads = settings.threads;
+            limits.stop = settings.stop;
+            PlayoutResult result = monteCarlo.search(position, player, limits);
+            move.cell = result.cell;
+            move.playouts = result.playouts;
+            break;
+        }
+    }
+    return move;
+}
+
+// A table lookup on 3x3, a time-bounded search otherwise
+void AIPlayer::bestMove(const GridPosition& position, char player, const AISettings& settings, AIMove& move) {
+    if (shape.size == 3 && shape.winLength == 3 && shape.layers == 1) {
+        Bitboard classic;
+        classic.x = static_cast<BoardMask>(position.x);
+        classic.o = static_cast<BoardMask>(position.o);
+        move.cell = perfectPlay(classic, player == 'O').cell;
+        return;
+    }
+
+    SearchLimits limits;
+    limits.timeBudgetMs = settings.timeBudgetMs;
+    limits.threads = settings.threads;
+    limits.stop = settings.stop;
+    SearchResult result = engine.search(position, player, limits);
+    move.cell = result.cell;
+    move.nodes += result.nodes;
+    move.depth = result.depth;
+    move.tableProbes += result.tableProbes;
+    move.tableHits += result.tableHits;
+}
+
+// Any empty cell, each equally likely
+int AIPlayer::randomMove(const GridPosition& position) {
+    GridMask empty = shape.full & ~position.occupied();
+    if (empty == 0) {
+        return -1;
+    }
+
+    // Skip to the randomIndex-th empty cell in row-major order
+    int randomIndex = nextRandom(__builtin_popcountll(empty));
+    for (int i = 0; i < randomIndex; i++) {
+        empty &= empty - 1;
+    }
+    return __builtin_ctzll(empty);
+}
+
+// The first cell in row-major order that wins for the player, or -1
+int AIPlayer::winningMove(const GridPosition& position, char player) const {
+    GridMask own = position.cells(player);
+    GridMask wins = shape.winningCells(own, position.occupied() & ~own);
+    return wins == 0 ? -1 : __builtin_ctzll(wins);
+}
+
+// Uniform in [0, bound), from a xorshift64 generator
+int AIPlayer::nextRandom(int bound) {
+    random ^= random << 13;
+    random ^= random >> 7;
+    random ^= random << 17;
+    return static_cast<int>(random % static_cast<uint64_t>(bound));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "engine.h"
+#include "mcts.h"
+#include "policy_table.h"
+
+const int DEFAULT_AI_TIME_BUDGET_MS = 1000;
+const int DEFAULT_AI_PLAYOUTS = 50000;
+
+// Game difficulty levels
+enum class Difficulty { EASY, MEDIUM, HARD, MONTE_CARLO };
+
+// Lower-case name used on the command line and in reports
+const char* difficultyName(Difficulty difficulty);
+// Accepts the names above; false for anything else
+bool parseDifficulty(const std::string& name, Difficulty& difficulty);
+
+// How much work the AI may put into one move
+struct AISettings {
+    int timeBudgetMs;           // alpha-beta search on boards larger than 3x3
+    int threads;
+    int playouts;               // Monte Carlo difficulty
+    const StopSignal* stop;     // ends any search early, see StopSignal; nullptr for none
+    const PolicyTable* policy;  // learned table Medium plays from on 3x3; nullptr for the rules
+    int policyStrength;         // 0 (near random) to 100 (always the best value)
+
+    AISettings() : timeBudgetMs(DEFAULT_AI_TIME_BUDGET_MS), threads(1), playouts(DEFAULT_AI_PLAYOUTS),
+                   stop(nullptr), policy(nullptr), policyStrength(DEFAULT_POLICY_STRENGTH) {}
+};
+
+struct AIMove {
+    int cell;                   // -1 if there is no legal move
+    unsigned long long nodes;   // alpha-beta nodes searched
+    int depth;                  // alpha-beta depth reached
+    unsigned long long playouts;
+    unsigned long long tableProbes;     // alpha-beta transposition table lookups
+    unsigned long long tableHits;
+};
+
+// Chooses moves for every difficulty on one board variant. It owns the
+// search state carried between turns and its own random numbers, so each
+// thread playing games needs its own AIPlayer, and nothing is shared.
+class AIPlayer {
+public:
+    AIPlayer(const BoardGeometry& geometry, uint64_t seed);
+
+    const BoardGeometry& geometry() const { return shape; }
+    void reseed(uint64_t seed) { random = seed | 1; }
+
+    AIMove chooseMove(const GridPosition& position, char player, Difficulty difficulty,
+                      const AISettings& settings);
+
+private:
+    const BoardGeometry& shape;
+    SearchEngine engine;
+    MonteCarloSearch monteCarlo;
+    uint64_t random;
+
+    void bestMove(const GridPosition& position, char player, const AISettings& settings, AIMove& move);
+    int randomMove(const GridPosition& position);
+    int winningMove(const GridPosition& position, char player) const;
+    int nextRandom(int bound);
+};
@@ -0,0 +1,383 @@
+#include "analyzer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "ai_player.h"
+#include "bitboard.h"
+#include "perfect_play.h"
+#include "thread_pool.h"
+#include "win_batch.h"
+
+using namespace std;
+
+namespace {
+
+const size_t GAMES_PER_BLOCK = 1 << 14;
+const size_t GAMES_PER_TASK = 64;
+const int CLASSIC_WIN_SCORE = 10;       // perfect-play score of a finished win
+
+// -1 lost, 0 undecided or drawn, 1 won, from the mover's point of view
+int outcomeOf(int score, int winThreshold) {
+    return score >= winThreshold ? 1 : score <= -winThreshold ? -1 : 0;
+}
+
+MoveQuality classify(int best, int played, int winThreshold) {
+    if (played >= best) return MoveQuality::OPTIMAL;
+    if (outcomeOf(played, winThreshold) < outcomeOf(best, winThreshold)) return MoveQuality::BLUNDER;
+    return MoveQuality::INACCURATE;
+}
+
+// Judges moves with one search engine per board variant, so each worker
+// needs its own
+class MoveJudge {
+public:
+    explicit MoveJudge(const AnalyzeOptions& options) : options(options) {}
+
+    // Judge the moves in order, after the random opening ones; returns
+    // the moves up to the end of the game, which is fewer than the move
+    // count if the game goes on after it ended
+    int judge(const GameRecord& game, MoveQuality verdicts[]) {
+        const BoardGeometry& geometry = BoardGeometry::get(game.boardSize, game.winLength, game.layers);
+        bool classic = geometry.size == 3 && geometry.winLength == 3 && geometry.layers == 1;
+        GridPosition position;
+        char player = game.firstPlayer;
+        for (int k = 0; k < game.moveCount; k++) {
+            int cell = game.moves[k];
+            if (k < game.openingMoves) {
+                verdicts[k] = MoveQuality::OPTIMAL;     // not counted
+            } else {
+                verdicts[k] = classic ? judgeClassic(position, player, cell)
+                                      : judgeSearched(geometry, position, player, cell);
+            }
+            position.place(cell, player);
+            if (geometry.completesLine(position.cells(player), cell) || position.occupied() == geometry.full) {
+                return k + 1;
+            }
+            player = player == 'X' ? 'O' : 'X';
+        }
+        return game.moveCount;
+    }
+
+private:
+    const AnalyzeOptions& options;
+    map<const BoardGeometry*, unique_ptr<SearchEngine> > engines;
+
+    // Perfect-play score of a 3x3 position for the side to move
+    static int classicScore(const GridPosition& position, char player) {
+        Bitboard board;
+        board.x = static_cast<BoardMask>(position.x);
+        board.o = static_cast<BoardMask>(position.o);
+        int score = perfectPlay(board, player == 'O').score;
+        return player == 'O' ? score : -score;
+    }
+
+    // Exact: the played move's score, one ply further from the end, is
+    // compared with the best score the position has
+    static MoveQuality judgeClassic(const GridPosition& position, char player, int cell) {
+        const BoardGeometry& geometry = BoardGeometry::get(3, 3);
+        int best = classicScore(position, player);
+        GridPosition after = position;
+        after.place(cell, player);
+        int played = 0;
+        if (geometry.completesLine(after.cells(player), cell)) {
+            played = CLASSIC_WIN_SCORE;
+        } else if (after.occupied() != geometry.full) {
+            played = -classicScore(after, player == 'X' ? 'O' : 'X');
+        }
+        played = played > 0 ? played - 1 : played < 0 ? played + 1 : 0;
+        return classify(best, played, 1);
+    }
+
+    // The played move is scored in the same root search that finds the
+    // best one, so both come from the same depth; the search's own choice
+    // is optimal by definition. While neither score is a forced result they
+    // are only the evaluation's estimate, which cannot tell a worse move
+    // from a different one, so only a lost win or draw counts against it.
+    MoveQuality judgeSearched(const BoardGeometry& geometry, const GridPosition& position, char player, int cell) {
+        SearchEngine& engine = engineFor(geometry);
+        SearchLimits limits;
+        limits.timeBudgetMs = options.timeBudgetMs;
+        limits.maxDepth = options.depth;
+        limits.scoreMove = cell;
+        SearchResult best = engine.search(position, player, limits);
+        if (best.cell == cell) {
+            return MoveQuality::OPTIMAL;
+        }
+        if (outcomeOf(best.score, WIN_THRESHOLD) == 0 && outcomeOf(best.moveScore, WIN_THRESHOLD) == 0) {
+            return MoveQuality::OPTIMAL;
+        }
+        return classify(best.score, best.moveScore, WIN_THRESHOLD);
+    }
+
+    SearchEngine& engineFor(const BoardGeometry& geometry) {
+        unique_ptr<SearchEngine>& engine = engines[&geometry];
+        if (!engine) {
+            engine.reset(new SearchEngine(geometry));
+        }
+        return *engine;
+    }
+};
+
+// Counts from the games one worker judged
+struct WorkerTally {
+    long long unreadable;
+    long long wrongResults;
+    long long openingMoves;
+    MoveTally byKind[PLAYER_KIND_COUNT];
+
+    WorkerTally() : unreadable(0), wrongResults(0), openingMoves(0) {}
+};
+
+// Result letter a game log uses for each board status
+const char RESULT_OF[4] = {' ', 'X', 'O', 'D'};
+
+// Replay each game to its last move and classify the final boards in
+// runs of the same board variant; returns how many disagree with the log
+long long countWrongResults(const GameRecord* games, size_t count) {
+    GridPosition finals[GAMES_PER_TASK];
+    BoardStatus statuses[GAMES_PER_TASK];
+    for (size_t i = 0; i < count; i++) {
+        char player = games[i].firstPlayer;
+        finals[i] = GridPosition();
+        for (int k = 0; k < games[i].moveCount; k++) {
+            finals[i].place(games[i].moves[k], player);
+            player = player == 'X' ? 'O' : 'X';
+        }
+    }
+
+    long long wrong = 0;
+    for (size_t first = 0, last; first < count; first = last) {
+        last = first + 1;
+        while (last < count && games[last].boardSize == games[first].boardSize &&
+               games[last].winLength == games[first].winLength && games[last].layers == games[first].layers) {
+            last++;
+        }
+        const BoardGeometry& geometry =
+            BoardGeometry::get(games[first].boardSize, games[first].winLength, games[first].layers);
+        classifyBoards(geometry, finals + first, last - first, statuses + first);
+        for (size_t i = first; i < last; i++) {
+            if (RESULT_OF[static_cast<int>(statuses[i])] != games[i].result) wrong++;
+        }
+    }
+    return wrong;
+}
+
+const char* kindName(int kind) {
+    return kind == 0 ? "human" : difficultyName(static_cast<Difficulty>(kind - 1));
+}
+
+// One line per game, with moves written as 1-based row and column (layer,
+// row and column on a cube) and marked ? when inaccurate and ?? when a
+// blunder. A | follows the random opening moves, which are not judged.
+string describeGame(long long number, const GameRecord& game, const MoveQuality verdicts[], int judged) {
+    ostringstream line;
+    int size = game.boardSize;
+    line << "game " << number << " " << size << "x" << size;
+    if (game.layers > 1) line << "x" << static_cast<int>(game.layers);
+    line << "/" << static_cast<int>(game.winLength)
+         << " X " << kindName(game.xLevel + 1);
+    if (game.xPlayer != NO_PLAYER) line << " #" << game.xPlayer;
+    line << " O " << kindName(game.oLevel + 1);
+    if (game.oPlayer != NO_PLAYER) line << " #" << game.oPlayer;
+    line << " result " << (game.result == 'D' ? "draw" : game.result == ' ' ? "none" : string(1, game.result)) << ":";
+    for (int k = 0; k < game.moveCount; k++) {
+        int cell = game.moves[k];
+        line << " ";
+        if (game.layers > 1) line << cell / (size * size) + 1;
+        line << cell / size % size + 1 << cell % size + 1;
+        if (k >= judged) line << "!";   // after the end
+        else if (k < game.openingMoves) line << (k + 1 == game.openingMoves ? " |" : "");
+        else if (verdicts[k] == MoveQuality::INACCURATE) line << "?";
+        else if (verdicts[k] == MoveQuality::BLUNDER) line << "??";
+    }
+    line << "\n";
+    return line.str();
+}
+
+void printTally(const char* label, const MoveTally& tally) {
+    double moves = tally.moves > 0 ? static_cast<double>(tally.moves) : 1.0;
+    cout << "  " << left << setw(7) << label << right << setw(12) << tally.moves << " moves, "
+         << fixed << setprecision(1) << 100.0 * tally.optimal / moves << "% optimal, "
+         << 100.0 * tally.inaccurate / moves << "% inaccurate, "
+         << 100.0 * tally.blunders / moves << "% blunders\n";
+}
+
+void printUsage() {
+    cout << "Usage: TicTacToe_Project --analyze LOG [options]\n"
+         << "  --workers N       threads judging games (default: one per core)\n"
+         << "  --depth N         search depth on boards larger than 3x3 (default 4)\n"
+         << "  --time-budget MS  longest search per move on those boards (default 1000)\n"
+         << "  --list            print every game, marking inaccuracies ? and blunders ??\n";
+}
+
+}
+
+void MoveTally::add(const MoveTally& other) {
+    moves += other.moves;
+    optimal += other.optimal;
+    inaccurate += other.inaccurate;
+    blunders += other.blunders;
+}
+
+AnalyzeOptions::AnalyzeOptions()
+    : logFile(GAME_LOG_FILE), workers(max(1, static_cast<int>(thread::hardware_concurrency()))),
+      depth(4), timeBudgetMs(1000), list(false) {
+}
+
+bool runAnalysis(const AnalyzeOptions& options, AnalyzeReport& report) {
+    GameLogReader reader(options.logFile);
+    if (!reader.open()) {
+        return false;
+    }
+
+    int workers = max(1, options.workers);
+    vector<unique_ptr<MoveJudge> > judges;
+    for (int w = 0; w < workers; w++) {
+        judges.push_back(unique_ptr<MoveJudge>(new MoveJudge(options)));
+    }
+    vector<WorkerTally> tallies(workers);
+    ThreadPool pool(workers);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    // Read a block of games, judge it in small slices that idle workers
+    // steal, then print its listing in log order
+    vector<GameRecord> games;
+    long long first = 0;
+    while (reader.read(games, GAMES_PER_BLOCK)) {
+        size_t taskCount = (games.size() + GAMES_PER_TASK - 1) / GAMES_PER_TASK;
+        vector<string> listings(options.list ? taskCount : 0);
+        vector<ThreadPool::Task> tasks;
+        for (size_t t = 0; t < taskCount; t++) {
+            tasks.push_back([&, t](int worker) {
+                MoveJudge& judge = *judges[worker];
+                WorkerTally& tally = tallies[worker];
+                MoveQuality verdicts[MAX_CELLS];
+                size_t last = min(games.size(), (t + 1) * GAMES_PER_TASK);
+                tally.wrongResults += countWrongResults(games.data() + t * GAMES_PER_TASK,
+                                                        last - t * GAMES_PER_TASK);
+                for (size_t i = t * GAMES_PER_TASK; i < last; i++) {
+                    const GameRecord& game = games[i];
+                    int judged = judge.judge(game, verdicts);
+                    if (judged < game.moveCount) tally.unreadable++;
+
+                    // Random opening moves belong to neither side
+                    int openings = min<int>(game.openingMoves, judged);
+                    tally.openingMoves += openings;
+                    char player = game.firstPlayer;
+                    if (openings % 2 == 1) player = player == 'X' ? 'O' : 'X';
+                    for (int k = openings; k < judged; k++) {
+                        MoveTally& kind = tally.byKind[(player == 'X' ? game.xLevel : game.oLevel) + 1];
+                        kind.moves++;
+                        if (verdicts[k] == MoveQuality::OPTIMAL) kind.optimal++;
+                        else if (verdicts[k] == MoveQuality::INACCURATE) kind.inaccurate++;
+                        else kind.blunders++;
+                        player = player == 'X' ? 'O' : 'X';
+                    }
+                    if (options.list) {
+                        listings[t] += describeGame(first + static_cast<long long>(i), game, verdicts, judged);
+                    }
+                }
+            });
+        }
+        pool.run(tasks);
+        for (size_t t = 0; t < listings.size(); t++) {
+            cout << listings[t];
+        }
+        first += static_cast<long long>(games.size());
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    report = AnalyzeReport();
+    report.games = first;
+    for (int w = 0; w < workers; w++) {
+        report.unreadable += tallies[w].unreadable;
+        report.wrongResults += tallies[w].wrongResults;
+        report.openingMoves += tallies[w].openingMoves;
+        for (int kind = 0; kind < PLAYER_KIND_COUNT; kind++) {
+            report.byKind[kind].add(tallies[w].byKind[kind]);
+            report.total.add(tallies[w].byKind[kind]);
+        }
+    }
+    report.bytes = reader.bytesRead();
+    report.damaged = reader.damaged();
+    report.seconds = elapsed.count();
+    return true;
+}
+
+int analyzeMain(int argc, char* argv[]) {
+    AnalyzeOptions options;
+    bool logGiven = false;
+
+    for (int i = 0; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--help") {
+            printUsage();
+            return 0;
+        }
+        if (flag == "--list") {
+            options.list = true;
+            continue;
+        }
+        if (flag.compare(0, 2, "--") != 0) {
+            options.logFile = flag;
+            logGiven = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cout << "Missing value for " << flag << "\n";
+            printUsage();
+            return 1;
+        }
+        string value = argv[++i];
+        if (flag == "--workers") options.workers = atoi(value.c_str());
+        else if (flag == "--depth") options.depth = atoi(value.c_str());
+        else if (flag == "--time-budget") options.timeBudgetMs = atoi(value.c_str());
+        else {
+            cout << "Invalid option: " << flag << " " << value << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (!logGiven || options.workers < 1 || options.depth < 1 || options.timeBudgetMs < 1) {
+        cout << "Give a game log, and positive workers, depth and time budget\n";
+        printUsage();
+        return 1;
+    }
+
+    AnalyzeReport report;
+    if (!runAnalysis(options, report)) {
+        cout << "Could not read " << options.logFile << " as a game log\n";
+        return 1;
+    }
+
+    double seconds = report.seconds > 0 ? report.seconds : 1e-9;
+    cout << fixed << setprecision(1);
+    cout << "Analyzed " << report.games << " games, " << report.total.moves << " moves in "
+         << report.seconds << " s on " << options.workers << " workers\n";
+    cout << "Throughput: " << report.games / seconds << " games/s, " << report.total.moves / seconds
+         << " moves/s, " << report.bytes / seconds / (1 << 20) << " MB/s\n";
+    printTally("all", report.total);
+    for (int kind = 0; kind < PLAYER_KIND_COUNT; kind++) {
+        if (report.byKind[kind].moves > 0) printTally(kindName(kind), report.byKind[kind]);
+    }
+    if (report.openingMoves > 0) {
+        cout << report.openingMoves << " random opening moves were not judged\n";
+    }
+    if (report.unreadable > 0) {
+        cout << report.unreadable << " games have moves after the game ended\n";
+    }
+    if (report.wrongResults > 0) {
+        cout << report.wrongResults << " games record a result their final board does not show\n";
+    }
+    if (report.damaged) {
+        cout << "The log ends in a damaged or partial record\n";
+    }
+    return 0;
+}
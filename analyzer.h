@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include "gamelog.h"
+
+// What the analyzer thinks of one move
+enum class MoveQuality : char {
+    OPTIMAL,        // keeps the best result the position offers
+    INACCURATE,     // a worse score, but no worse an outcome
+    BLUNDER         // throws away a win or a draw
+};
+
+// Settings for reading a game log and judging every move in it
+struct AnalyzeOptions {
+    std::string logFile;
+    int workers;                // threads judging games
+    int depth;                  // alpha-beta depth on boards larger than 3x3
+    int timeBudgetMs;           // cap on each of those searches
+    bool list;                  // print every game with its moves marked
+
+    AnalyzeOptions();
+};
+
+// Move counts for one kind of player
+struct MoveTally {
+    long long moves;
+    long long optimal;
+    long long inaccurate;
+    long long blunders;
+
+    MoveTally() : moves(0), optimal(0), inaccurate(0), blunders(0) {}
+    void add(const MoveTally& other);
+};
+
+const int PLAYER_KIND_COUNT = 5;        // a person, then each Difficulty
+
+struct AnalyzeReport {
+    long long games;
+    long long unreadable;       // games whose moves go on after the end
+    long long wrongResults;     // recorded result differs from the final board
+    long long openingMoves;     // random opening moves, left out of the tallies
+    MoveTally total;
+    MoveTally byKind[PLAYER_KIND_COUNT];
+    unsigned long long bytes;
+    bool damaged;               // the log ended in a partial record
+    double seconds;
+};
+
+// Judge every move of every game in the log on all the workers, except
+// the random opening moves a record marks as played by neither side.
+// 3x3 moves are judged exactly from the perfect-play table; larger boards
+// score the move played in the same fixed-depth search that finds the
+// best move, and call it inaccurate only when both scores are forced
+// results. The final boards are classified in batches to check the
+// recorded results. With options.list each game is printed, in log
+// order, as it is judged.
+// Returns false if the log cannot be read.
+bool runAnalysis(const AnalyzeOptions& options, AnalyzeReport& report);
+
+// Entry point for --analyze: reads the options that follow it, analyzes
+// and prints the report. Returns the process exit code.
+int analyzeMain(int argc, char* argv[]);
@@ -0,0 +1,248 @@
+#include "batch.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "game.h"
+
+using namespace std;
+
+namespace {
+
+const size_t BLOCK_SIZE = 1 << 20;
+const long long MAX_REPORTED_ERRORS = 5;
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Plays one line at a time straight out of the read buffer: no line
+// copies, no streams, and the name strings keep their capacity between
+// lines, so a game costs a few table lookups
+class BatchParser {
+public:
+    BatchParser(const BatchOptions& options, LeaderboardStore& leaderboard, BatchReport& report)
+        : options(options), geometry(BoardGeometry::get(options.boardSize, options.winLength)),
+          leaderboard(leaderboard), report(report) {}
+
+    void parseLine(const char* begin, const char* end) {
+        report.lines++;
+        const char* p = skipBlanks(begin, end);
+        if (p == end || *p == '#') {
+            return;
+        }
+        if (!readName(p, end, xName) || !readName(p, end, oName)) {
+            fail("expected <X player>,<O player>,<moves> with names of 1-31 characters");
+            return;
+        }
+
+        int size = geometry.size;
+        GridPosition position;
+        char player = 'X';
+        char result = ' ';      // 'X' or 'O' once won, 'D' for a full board
+        while ((p = skipBlanks(p, end)) != end) {
+            if (result != ' ') {
+                fail("moves after the game ended");
+                return;
+            }
+            int row = p[0] - '1';
+            int col = end - p >= 2 ? p[1] - '1' : -1;
+            p += 2;
+            if (row < 0 || row >= size || col < 0 || col >= size || (p < end && !isBlank(*p))) {
+                fail("a move must be a row digit and a column digit, such as 21");
+                return;
+            }
+            int cell = row * size + col;
+            if (!position.isEmpty(cell)) {
+                fail("move on a taken cell");
+                return;
+            }
+
+            position.place(cell, player);
+            if (geometry.completesLine(position.cells(player), cell)) {
+                result = player;
+            } else if (position.occupied() == geometry.full) {
+                result = 'D';
+            }
+            player = player == 'X' ? 'O' : 'X';
+        }
+
+        if (result == ' ') {
+            report.unfinished++;
+            return;
+        }
+        int x = leaderboard.addPlayer(xName);
+        int o = leaderboard.addPlayer(oName);
+        if (x < 0 || o < 0) {
+            fail("the leaderboard cannot take more players");
+            return;
+        }
+        if (result == 'D') {
+            leaderboard.record(x, GameOutcome::DRAW);
+            leaderboard.record(o, GameOutcome::DRAW);
+            report.draws++;
+        } else {
+            leaderboard.record(x, result == 'X' ? GameOutcome::WIN : GameOutcome::LOSS);
+            leaderboard.record(o, result == 'O' ? GameOutcome::WIN : GameOutcome::LOSS);
+            (result == 'X' ? report.xWins : report.oWins)++;
+        }
+        report.games++;
+    }
+
+private:
+    const BatchOptions& options;
+    const BoardGeometry& geometry;
+    LeaderboardStore& leaderboard;
+    BatchReport& report;
+    string xName;
+    string oName;
+
+    static const char* skipBlanks(const char* p, const char* end) {
+        while (p < end && isBlank(*p)) p++;
+        return p;
+    }
+
+    // Read up to the next ',' with surrounding blanks trimmed
+    static bool readName(const char*& p, const char* end, string& name) {
+        const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+        if (!comma) {
+            return false;
+        }
+        const char* first = skipBlanks(p, comma);
+        const char* last = comma;
+        while (last > first && isBlank(last[-1])) last--;
+        name.assign(first, last);
+        p = comma + 1;
+        return !name.empty() && name.size() <= static_cast<size_t>(MAX_NAME_LENGTH);
+    }
+
+    void fail(const char* reason) {
+        report.errors++;
+        if (!options.quiet && report.errors <= MAX_REPORTED_ERRORS) {
+            cout << "Line " << report.lines << ": " << reason << "\n";
+        }
+    }
+};
+
+void printUsage() {
+    cout << "Usage: TicTacToe_Project --batch FILE|- [options]\n"
+         << "  Plays one game per line, \"X player,O player,11 22 ...\", from FILE or\n"
+         << "  standard input (-), and adds the results to the leaderboard.\n"
+         << "  --board N          board size: 3, 5 or 7 (default 3)\n"
+         << "  --win K            marks in a row to win (default for the board)\n"
+         << "  --leaderboard PATH leaderboard file (default " << LEADERBOARD_FILE << ")\n"
+         << "  --quiet            do not print the first errors\n";
+}
+
+}
+
+BatchOptions::BatchOptions()
+    : boardSize(BOARD_SIZE), winLength(BOARD_SIZE), leaderboardFile(LEADERBOARD_FILE), quiet(false) {
+}
+
+BatchReport runBatch(FILE* input, const BatchOptions& options, LeaderboardStore& leaderboard) {
+    BatchReport report = BatchReport();
+    BatchParser parser(options, leaderboard, report);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    // Whole lines are parsed where they lie; the partial line at the end
+    // of a block moves to the front before the next read
+    vector<char> buffer(BLOCK_SIZE);
+    size_t kept = 0;
+    while (true) {
+        size_t got = fread(buffer.data() + kept, 1, buffer.size() - kept, input);
+        const char* line = buffer.data();
+        const char* limit = line + kept + got;
+        const char* newline;
+        while ((newline = static_cast<const char*>(memchr(line, '\n', limit - line))) != nullptr) {
+            parser.parseLine(line, newline);
+            line = newline + 1;
+        }
+        kept = static_cast<size_t>(limit - line);
+
+        if (got == 0) {
+            if (kept > 0) parser.parseLine(line, limit);
+            break;
+        }
+        memmove(buffer.data(), line, kept);
+        if (kept == buffer.size()) {
+            buffer.resize(buffer.size() * 2); // One very long line
+        }
+    }
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    report.seconds = elapsed.count();
+    return report;
+}
+
+int batchMain(int argc, char* argv[]) {
+    BatchOptions options;
+    bool winGiven = false;
+    string source;
+
+    for (int i = 0; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--help") {
+            printUsage();
+            return 0;
+        }
+        if (flag == "--quiet") {
+            options.quiet = true;
+            continue;
+        }
+        if (flag.compare(0, 2, "--") != 0) {
+            source = flag;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cout << "Missing value for " << flag << "\n";
+            printUsage();
+            return 1;
+        }
+        string value = argv[++i];
+        if (flag == "--board") options.boardSize = atoi(value.c_str());
+        else if (flag == "--win") { options.winLength = atoi(value.c_str()); winGiven = true; }
+        else if (flag == "--leaderboard") options.leaderboardFile = value;
+        else {
+            cout << "Invalid option: " << flag << " " << value << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (!winGiven) {
+        options.winLength = defaultWinLength(options.boardSize);
+    }
+    if (source.empty() || options.boardSize < 3 || options.boardSize > 9 || options.boardSize > MAX_BOARD_SIZE ||
+        options.winLength < 3 || options.winLength > options.boardSize) {
+        cout << "Give a game file (or - for standard input) and a valid board\n";
+        printUsage();
+        return 1;
+    }
+
+    FILE* input = source == "-" ? stdin : fopen(source.c_str(), "rb");
+    if (!input) {
+        cout << "Could not open " << source << "\n";
+        return 1;
+    }
+    LeaderboardStore leaderboard(options.leaderboardFile);
+    if (!leaderboard.open()) {
+        cout << "Could not open " << options.leaderboardFile << "\n";
+        if (input != stdin) fclose(input);
+        return 1;
+    }
+
+    BatchReport report = runBatch(input, options, leaderboard);
+    if (input != stdin) fclose(input);
+
+    double seconds = report.seconds > 0 ? report.seconds : 1e-9;
+    cout << fixed << setprecision(1);
+    cout << "Read " << report.lines << " lines in " << report.seconds << " s, "
+         << report.games / seconds << " games/s\n";
+    cout << "Games: " << report.games << " (X wins " << report.xWins << ", O wins " << report.oWins
+         << ", draws " << report.draws << ")\n";
+    cout << "Unfinished: " << report.unfinished << ", errors: " << report.errors << "\n";
+    return report.errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include "leaderboard_store.h"
+
+// Batch mode plays recorded games with no prompts or screen output and
+// adds their results to the leaderboard. Input is one game per line:
+//
+//   <X player>,<O player>,<moves>
+//
+// where each move is the row and column digits of a cell, 1-based as on
+// screen, and moves are separated by spaces: "Ann,Bob,22 11 33 13 12".
+// Blank lines and lines starting with '#' are skipped. A game that ends
+// before its last move, or has an illegal move, counts as an error; one
+// whose moves run out before anybody wins or the board fills counts as
+// unfinished. Neither changes the leaderboard.
+struct BatchOptions {
+    int boardSize;
+    int winLength;
+    std::string leaderboardFile;
+    bool quiet;                 // do not print the first errors
+
+    BatchOptions();
+};
+
+struct BatchReport {
+    long long lines;
+    long long games;            // finished games added to the leaderboard
+    long long xWins;
+    long long oWins;
+    long long draws;
+    long long unfinished;
+    long long errors;
+    double seconds;
+};
+
+// Read `input` to the end in large blocks and parse it in place
+BatchReport runBatch(FILE* input, const BatchOptions& options, LeaderboardStore& leaderboard);
+
+// Entry point for --batch: reads the options that follow it, plays and
+// prints the report. Returns the process exit code.
+int batchMain(int argc, char* argv[]);
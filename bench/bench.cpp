@@ -0,0 +1,426 @@
+// Micro-benchmarks for the engine and persistence hot paths.
+//
+// Every benchmark runs once to warm up, then finds a call count that takes
+// at least 50 ms and times several batches of it. The median batch is
+// reported as time per call, next to heap allocations and bytes per call
+// counted by the replaced operator new. Inputs are fixed, so runs on the
+// same machine are comparable.
+//
+// Usage: TicTacToe_Bench [name filter]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "../classic_search.h"
+#include "../game.h"
+#include "../tictactoe.h"
+#include "../trainer.h"
+#include "../win_batch.h"
+
+using namespace std;
+
+namespace {
+
+atomic<unsigned long long> allocationCount(0);
+atomic<unsigned long long> allocatedBytes(0);
+
+// Out of line, so the compiler does not pair the free with a new it can see
+__attribute__((noinline)) void release(void* memory) {
+    free(memory);
+}
+
+}
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocatedBytes.fetch_add(size, memory_order_relaxed);
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (!memory) throw bad_alloc();
+    return memory;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    release(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    release(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    release(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    release(memory);
+}
+
+namespace {
+
+const char SCRATCH_LEADERBOARD[] = "bench_leaderboard.dat";
+const char SCRATCH_GAME_LOG[] = "bench_games.log";
+const int SAMPLES = 5;
+const chrono::milliseconds MIN_BATCH_TIME(50);
+
+// Keeps results alive so the optimizer cannot drop the calls
+volatile long long sink = 0;
+
+struct BenchResult {
+    long long calls;
+    double nanosecondsPerCall;
+    double allocationsPerCall;
+    double bytesPerCall;
+};
+
+template <typename Body>
+double timeBatch(Body& body, long long calls) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long long i = 0; i < calls; i++) {
+        body(i);
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+}
+
+template <typename Body>
+BenchResult measure(Body body, int samples = SAMPLES) {
+    body(0);
+
+    long long calls = 1;
+    while (timeBatch(body, calls) < chrono::duration<double, nano>(MIN_BATCH_TIME).count() && calls < (1LL << 40)) {
+        calls *= 2;
+    }
+
+    unsigned long long allocationsBefore = allocationCount.load();
+    unsigned long long bytesBefore = allocatedBytes.load();
+    vector<double> perCall;
+    for (int s = 0; s < samples; s++) {
+        perCall.push_back(timeBatch(body, calls) / calls);
+    }
+    double totalCalls = static_cast<double>(calls) * samples;
+
+    sort(perCall.begin(), perCall.end());
+    BenchResult result;
+    result.calls = calls * samples;
+    result.nanosecondsPerCall = perCall[samples / 2];
+    result.allocationsPerCall = (allocationCount.load() - allocationsBefore) / totalCalls;
+    result.bytesPerCall = (allocatedBytes.load() - bytesBefore) / totalCalls;
+    return result;
+}
+
+void printHeader() {
+    cout << left << setw(36) << "benchmark" << right << setw(12) << "calls" << setw(16) << "ns/call"
+         << setw(14) << "allocs/call" << setw(14) << "bytes/call" << "\n";
+}
+
+void printResult(const string& name, const BenchResult& result) {
+    cout << left << setw(36) << name << right << setw(12) << result.calls
+         << fixed << setprecision(1) << setw(16) << result.nanosecondsPerCall
+         << setprecision(2) << setw(14) << result.allocationsPerCall
+         << setprecision(1) << setw(14) << result.bytesPerCall << "\n";
+}
+
+// Positions played from a fixed seed: `plies` random moves with no winner
+vector<GridPosition> samplePositions(const BoardGeometry& geometry, int plies, int count) {
+    vector<GridPosition> positions;
+    uint64_t random = 0x5EED;
+    while (static_cast<int>(positions.size()) < count) {
+        GridPosition position;
+        char player = 'X';
+        bool over = false;
+        for (int ply = 0; ply < plies && !over; ply++) {
+            int cell;
+            do {
+                random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+                cell = static_cast<int>((random >> 33) % geometry.cellTotal);
+            } while (!position.isEmpty(cell));
+            position.place(cell, player);
+            over = geometry.hasWin(position.cells(player));
+            player = player == 'X' ? 'O' : 'X';
+        }
+        if (!over) positions.push_back(position);
+    }
+    return positions;
+}
+
+// Boards with every cell independently empty, X or O, filled more densely
+// as the index grows: ongoing, won, drawn and even both-sides-won boards
+vector<GridPosition> randomBoards(const BoardGeometry& geometry, int count) {
+    vector<GridPosition> boards(count);
+    uint64_t random = 0xB0A2D;
+    for (int i = 0; i < count; i++) {
+        int emptyPercent = 60 - 60 * i / count;
+        for (int cell = 0; cell < geometry.cellTotal; cell++) {
+            random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+            int roll = static_cast<int>((random >> 33) % 100);
+            if (roll >= emptyPercent) boards[i].place(cell, roll % 2 == 0 ? 'X' : 'O');
+        }
+    }
+    return boards;
+}
+
+}
+
+// Friend of Game, so the private hot paths can be timed as they are
+class GameBenchmark {
+public:
+    explicit GameBenchmark(const string& filter) : filter(filter), game(SCRATCH_LEADERBOARD, SCRATCH_GAME_LOG) {}
+
+    // False if a batch kernel disagrees with checkWin/checkDraw
+    bool run() {
+        printHeader();
+        benchmarkBoardChecks();
+        bool batchMatches = benchmarkWinBatch();
+        benchmarkMinimaxSolve();
+        benchmarkBestMove();
+        benchmarkLeaderboard(10);
+        benchmarkLeaderboard(10000);
+        benchmarkLeaderboard(1000000);
+        game.leaderboard.reset();
+        benchmarkGameLog();
+        return batchMatches;
+    }
+
+private:
+    string filter;
+    Game game;
+
+    bool selected(const string& name) const {
+        return filter.empty() || name.find(filter) != string::npos;
+    }
+
+    template <typename Body>
+    void bench(const string& name, Body body, int samples = SAMPLES) {
+        if (!selected(name)) return;
+        printResult(name, measure(body, samples));
+    }
+
+    // checkWin and checkDraw over a mix of positions, on 3x3 and 7x7
+    void benchmarkBoardChecks() {
+        const int sizes[2][2] = {{3, 3}, {7, 5}};
+        for (int v = 0; v < 2; v++) {
+            game.selectBoard(sizes[v][0], sizes[v][1]);
+            vector<GridPosition> positions = samplePositions(*game.geometry, game.geometry->cellTotal / 2, 64);
+            string board = to_string(sizes[v][0]) + "x" + to_string(sizes[v][0]);
+
+            bench("checkWin " + board, [&](long long i) {
+                game.board = positions[i & 63];
+                sink = sink + game.checkWin(PLAYER_X);
+            });
+            bench("checkDraw " + board, [&](long long i) {
+                game.board = positions[i & 63];
+                sink = sink + game.checkDraw();
+            });
+        }
+        game.selectBoard(BOARD_SIZE, BOARD_SIZE);
+        game.initializeBoard();
+    }
+
+    // Each batch kernel on 1024 boards, after checking it bit for bit
+    // against checkWin(X), checkWin(O) and checkDraw on every board
+    bool benchmarkWinBatch() {
+        const int sizes[3][2] = {{3, 3}, {5, 4}, {7, 5}};
+        const BatchKernel kernels[3] = {BatchKernel::SCALAR, BatchKernel::SSE2, BatchKernel::AVX2};
+        const int BOARDS = 1024;
+        bool matches = true;
+        for (int v = 0; v < 3; v++) {
+            game.selectBoard(sizes[v][0], sizes[v][1]);
+            const BoardGeometry& geometry = *game.geometry;
+            // An odd count, so the scalar tail of the vector kernels runs too
+            vector<GridPosition> boards = randomBoards(geometry, 100003);
+            vector<BoardStatus> expected(boards.size());
+            for (size_t i = 0; i < boards.size(); i++) {
+                game.board = boards[i];
+                expected[i] = game.checkWin(PLAYER_X) ? BoardStatus::X_WON
+                            : game.checkWin(PLAYER_O) ? BoardStatus::O_WON
+                            : game.checkDraw() ? BoardStatus::DRAW : BoardStatus::ONGOING;
+            }
+
+            string board = to_string(sizes[v][0]) + "x" + to_string(sizes[v][0]);
+            vector<BoardStatus> statuses(boards.size());
+            for (int k = 0; k < 3; k++) {
+                if (!batchKernelSupported(kernels[k])) continue;
+                classifyBoards(geometry, boards.data(), boards.size(), statuses.data(), kernels[k]);
+                if (statuses != expected) {
+                    cout << "classifyBoards " << board << " " << batchKernelName(kernels[k])
+                         << " disagrees with checkWin/checkDraw\n";
+                    matches = false;
+                }
+                bench("classifyBoards " + board + " x1024 " + batchKernelName(kernels[k]), [&](long long i) {
+                    size_t first = static_cast<size_t>(i % 64) * BOARDS;
+                    classifyBoards(geometry, boards.data() + first, BOARDS, statuses.data(), kernels[k]);
+                    sink = sink + static_cast<int>(statuses[i & (BOARDS - 1)]);
+                });
+            }
+        }
+        game.selectBoard(BOARD_SIZE, BOARD_SIZE);
+        game.initializeBoard();
+        return matches;
+    }
+
+    // Minimax from the empty board, with the transposition table emptied
+    // first so every call is a complete solve
+    void benchmarkMinimaxSolve() {
+        ClassicSearch search;
+        bench("minimax solve 3x3 (cold table)", [&](long long) {
+            search.clearTable();
+            sink = sink + search.solve(Bitboard(), true);
+        });
+    }
+
+    // HARD moves: the table on 3x3, the minimax search it replaced, and a
+    // fixed-depth engine search with a cleared table on the larger boards
+    void benchmarkBestMove() {
+        const BoardGeometry& classic = BoardGeometry::get(3, 3);
+        vector<GridPosition> openings = samplePositions(classic, 2, 16);
+        Position position;
+        bench("findBestMove 3x3 (table)", [&](long long i) {
+            position.cells = openings[i & 15];
+            sink = sink + bestMove(position).cell;
+        });
+        if (selected("chooseMove 3x3 medium (learned table)")) {
+            TrainOptions training;
+            training.games = 200000;
+            training.workers = 1;
+            PolicyTable policy;
+            trainPolicy(training, policy);
+            bench("chooseMove 3x3 medium (learned table)", [&](long long i) {
+                const GridPosition& cells = openings[i & 15];
+                sink = sink + policy.chooseMove(cells.x, cells.o, DEFAULT_POLICY_STRENGTH, (i & 1023) / 1024.0);
+            });
+        }
+        ClassicSearch search;
+        bench("searchBestMove 3x3 (minimax)", [&](long long i) {
+            Bitboard board;
+            board.x = static_cast<BoardMask>(openings[i & 15].x);
+            board.o = static_cast<BoardMask>(openings[i & 15].o);
+            search.clearTable();
+            sink = sink + search.bestMove(board);
+        });
+
+        // size, win length, layers, depth
+        const int sizes[3][4] = {{5, 4, 1, 6}, {7, 5, 1, 4}, {4, 4, 4, 6}};
+        for (int v = 0; v < 3; v++) {
+            const BoardGeometry& geometry = BoardGeometry::get(sizes[v][0], sizes[v][1], sizes[v][2]);
+            vector<GridPosition> positions = samplePositions(geometry, 4, 8);
+            SearchEngine engine(geometry);
+            SearchLimits limits;
+            limits.timeBudgetMs = 1000000;
+            limits.maxDepth = sizes[v][3];
+            string name = "findBestMove " + to_string(sizes[v][0]) + "x" + to_string(sizes[v][0]) +
+                          (sizes[v][2] > 1 ? "x" + to_string(sizes[v][2]) : "") + " depth " + to_string(sizes[v][3]);
+            bench(name, [&](long long i) {
+                engine.clear();
+                sink = sink + engine.search(positions[i & 7], PLAYER_X, limits).cell;
+            }, 3);
+        }
+    }
+
+    // saveLeaderboard, loadLeaderboard, the per-result update and the
+    // ranking queries on a generated leaderboard
+    void benchmarkLeaderboard(int players) {
+        string size = players >= 1000000 ? to_string(players / 1000000) + "M"
+                    : players >= 1000 ? to_string(players / 1000) + "k" : to_string(players);
+        string saveName = "saveLeaderboard " + size + " players";
+        string loadName = "loadLeaderboard " + size + " players";
+        string updateName = "updateLeaderboard " + size + " players";
+        string buildName = "buildRanking " + size + " players";
+        string pageName = "rankPage " + size + " players";
+        string rankName = "rankOf " + size + " players";
+        if (!selected(saveName) && !selected(loadName) && !selected(updateName) && !selected(buildName) &&
+            !selected(pageName) && !selected(rankName)) return;
+
+        game.leaderboard.reset();
+        vector<string> names(players);
+        uint64_t random = 42;
+        char name[24];
+        for (int i = 0; i < players; i++) {
+            random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+            snprintf(name, sizeof(name), "player%07d", i);
+            names[i] = name;
+            game.leaderboard.setPlayer({name, static_cast<int>(random >> 54), static_cast<int>(random >> 44 & 1023),
+                                        static_cast<int>(random >> 34 & 1023)});
+        }
+        int samples = players >= 1000000 ? 3 : SAMPLES;
+
+        bench(saveName, [&](long long) {
+            game.saveLeaderboard();
+        }, samples);
+        // Reopening the file, as at start-up, and reading one player back
+        bench(loadName, [&](long long i) {
+            game.loadLeaderboard();
+            sink = sink + game.leaderboard.at(game.leaderboard.find(names[i % players])).wins;
+        }, samples);
+        // Built once, the first time the leaderboard is shown
+        bench(buildName, [&](long long) {
+            game.ranking.build(game.leaderboard);
+        }, samples);
+        // One in-place counter update per result, spread over every player,
+        // plus moving that player within the ranking
+        bench(updateName, [&](long long i) {
+            game.updateLeaderboard(names[(i * 7919) % players], (i & 1) != 0);
+        }, samples);
+        // One screen of the paged view, anywhere in the ranking
+        bench(pageName, [&](long long i) {
+            int first = static_cast<int>((i * 7919) % players) / LEADERBOARD_PAGE_SIZE * LEADERBOARD_PAGE_SIZE;
+            sink = sink + game.ranking.range(first, LEADERBOARD_PAGE_SIZE).back();
+        }, samples);
+        bench(rankName, [&](long long i) {
+            sink = sink + game.ranking.rankOf(static_cast<int>((i * 7919) % players));
+        }, samples);
+        game.ranking.clear();
+    }
+
+    // Packing and unpacking a full 3x3 and a long 7x7 game, and queueing a
+    // record for the background writer as a finished game does
+    void benchmarkGameLog() {
+        const int sizes[2][3] = {{3, 3, 9}, {7, 5, 30}};
+        uint8_t bytes[MAX_GAME_RECORD_BYTES];
+        for (int v = 0; v < 2; v++) {
+            GameRecord record;
+            record.boardSize = static_cast<uint8_t>(sizes[v][0]);
+            record.winLength = static_cast<uint8_t>(sizes[v][1]);
+            record.result = 'D';
+            for (int k = 0; k < sizes[v][2]; k++) {
+                record.moves[record.moveCount++] = static_cast<uint8_t>((k * 11) % (sizes[v][0] * sizes[v][0]));
+            }
+            string board = to_string(sizes[v][0]) + "x" + to_string(sizes[v][0]);
+            bench("encodeGameRecord " + board, [&](long long i) {
+                record.timestamp = static_cast<uint32_t>(i);
+                sink = sink + encodeGameRecord(record, bytes);
+            });
+            size_t length = encodeGameRecord(record, bytes);
+            GameRecord decoded;
+            bench("decodeGameRecord " + board, [&](long long) {
+                sink = sink + decodeGameRecord(bytes, length, decoded);
+            });
+            if (v == 0) {
+                bench("appendGameLog 3x3", [&](long long) {
+                    game.gameLog.append(record);
+                });
+            }
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    bool passed;
+    {
+        GameBenchmark benchmark(argc > 1 ? argv[1] : "");
+        passed = benchmark.run();
+    }
+    // The Game has closed its files; drop them
+    remove(SCRATCH_LEADERBOARD);
+    remove(SCRATCH_GAME_LOG);
+    return passed ? 0 : 1;
+}
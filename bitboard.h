@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+
+// One bit per cell, cell index = row * 3 + col (bit 0 is the top-left corner)
+typedef uint16_t BoardMask;
+
+constexpr BoardMask FULL_BOARD = 0x1FF;
+constexpr int WIN_LINE_COUNT = 8;
+
+// Every way to get three in a row: rows, columns, then both diagonals
+constexpr BoardMask WIN_LINES[WIN_LINE_COUNT] = {
+    0x007, 0x038, 0x1C0,
+    0x049, 0x092, 0x124,
+    0x111, 0x054
+};
+
+// Static move preference used to order the search
+constexpr BoardMask CENTER_CELL = 0x010;
+constexpr BoardMask CORNER_CELLS = 0x145;
+constexpr BoardMask EDGE_CELLS = 0x0AA;
+constexpr int MOVE_GROUP_COUNT = 5;
+
+// Index of the lowest set bit; the mask must not be empty
+constexpr int lowestCell(BoardMask mask) {
+    return __builtin_ctz(mask);
+}
+
+// Number of set bits in a mask
+constexpr int cellCount(BoardMask mask) {
+    return __builtin_popcount(mask);
+}
+
+// True if the mask covers at least one complete win line
+constexpr bool hasWinLine(BoardMask mask) {
+    for (int i = 0; i < WIN_LINE_COUNT; i++) {
+        if ((mask & WIN_LINES[i]) == WIN_LINES[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Empty cells that would complete a line for the side owning `own`
+inline BoardMask winningCells(BoardMask own, BoardMask empty) {
+    BoardMask cells = 0;
+    for (int i = 0; i < WIN_LINE_COUNT; i++) {
+        BoardMask missing = WIN_LINES[i] & ~own;
+        if (cellCount(missing) == 1 && (missing & empty)) {
+            cells |= missing;
+        }
+    }
+    return cells;
+}
+
+// Split the empty cells into search order: winning moves, blocking moves,
+// then center, corners and edges
+inline void orderMoves(BoardMask own, BoardMask opponent, BoardMask empty,
+                       BoardMask groups[MOVE_GROUP_COUNT]) {
+    BoardMask wins = winningCells(own, empty);
+    BoardMask blocks = winningCells(opponent, empty) & ~wins;
+    BoardMask rest = empty & ~(wins | blocks);
+    groups[0] = wins;
+    groups[1] = blocks;
+    groups[2] = rest & CENTER_CELL;
+    groups[3] = rest & CORNER_CELLS;
+    groups[4] = rest & EDGE_CELLS;
+}
+
+// A 3x3 position stored as one bitmask per side
+struct Bitboard {
+    BoardMask x;
+    BoardMask o;
+
+    Bitboard() : x(0), o(0) {}
+
+    // Mask of the cells owned by a player
+    BoardMask cells(char player) const {
+        return player == 'X' ? x : o;
+    }
+
+    // Mask of the cells nobody has played yet
+    BoardMask emptyCells() const {
+        return static_cast<BoardMask>(~(x | o) & FULL_BOARD);
+    }
+
+    bool isEmpty(int cell) const {
+        return ((x | o) >> cell & 1) == 0;
+    }
+
+    bool isFull() const {
+        return (x | o) == FULL_BOARD;
+    }
+
+    bool hasWon(char player) const {
+        return hasWinLine(cells(player));
+    }
+
+    // Symbol at a cell: 'X', 'O' or ' '
+    char at(int cell) const {
+        if (x >> cell & 1) return 'X';
+        if (o >> cell & 1) return 'O';
+        return ' ';
+    }
+
+    void place(int cell, char player) {
+        if (player == 'X') {
+            x |= static_cast<BoardMask>(1u << cell);
+        } else {
+            o |= static_cast<BoardMask>(1u << cell);
+        }
+    }
+
+    void remove(int cell) {
+        BoardMask keep = static_cast<BoardMask>(~(1u << cell));
+        x &= keep;
+        o &= keep;
+    }
+};
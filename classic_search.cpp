@@ -0,0 +1,126 @@
+#include "classic_search.h"
+#include <algorithm>
+
+using namespace std;
+
+ClassicSearch::ClassicSearch() : nodeCount(0) {
+}
+
+// Find the best move for O by searching with minimax; the perfect-play
+// table holds the same answers
+int ClassicSearch::bestMove(const Bitboard& position) {
+    board = position;
+    if (hasWinLine(board.x) || hasWinLine(board.o)) {
+        return -1;
+    }
+    int bestScore = -1000;
+    int bestCell = -1;
+    
+    BoardMask groups[MOVE_GROUP_COUNT];
+    orderMoves(board.o, board.x, board.emptyCells(), groups);
+    
+    for (int g = 0; g < MOVE_GROUP_COUNT; g++) {
+        for (BoardMask group = groups[g]; group; group &= group - 1) {
+            int cell = lowestCell(group);
+            
+            // Ties go to the cell that comes first in row-major order, so the
+            // ordered search picks the same move as a plain row-major scan
+            int alpha = (bestCell >= 0 && cell < bestCell) ? bestScore - 1 : bestScore;
+            
+            board.place(cell, 'O');
+            int score = minimax(0, false, alpha, 1000);
+            board.remove(cell);
+            
+            if (score > alpha) {
+                bestScore = score;
+                bestCell = cell;
+            }
+        }
+    }
+    
+    return bestCell;
+}
+
+// Value of the position for whoever is to move, on O's scale
+int ClassicSearch::solve(const Bitboard& position, bool oToMove) {
+    board = position;
+    return minimax(0, oToMove, -1000, 1000);
+}
+
+// Minimax algorithm with alpha-beta pruning for AI decision making
+int ClassicSearch::minimax(int depth, bool isMaximizing, int alpha, int beta) {
+    nodeCount++;
+    
+    if (hasWinLine(board.o)) return 10 - depth;
+    if (hasWinLine(board.x)) return depth - 10;
+    
+    BoardMask empty = board.emptyCells();
+    if (empty == 0) return 0;
+    
+    // Scores are cached relative to this position, so shift them by depth
+    PositionKey key = TranspositionTable::canonicalKey(board, isMaximizing);
+    int cached;
+    ScoreBound bound;
+    if (table.probe(key, cached, bound)) {
+        int score = cached > 0 ? cached - depth : cached < 0 ? cached + depth : 0;
+        if (bound == ScoreBound::EXACT ||
+            (bound == ScoreBound::LOWER && score >= beta) ||
+            (bound == ScoreBound::UPPER && score <= alpha)) {
+            return score;
+        }
+    }
+    
+    int bestScore = searchChildren(depth, isMaximizing, empty, alpha, beta);
+    
+    if (bestScore <= alpha) bound = ScoreBound::UPPER;
+    else if (bestScore >= beta) bound = ScoreBound::LOWER;
+    else bound = ScoreBound::EXACT;
+    
+    if (bestScore > 0) table.store(key, bestScore + depth, bound);
+    else if (bestScore < 0) table.store(key, bestScore - depth, bound);
+    else table.store(key, 0, bound);
+    
+    return bestScore;
+}
+
+// Try the empty cells for the side to move, most promising first, until
+// the alpha-beta window closes
+int ClassicSearch::searchChildren(int depth, bool isMaximizing, BoardMask empty, int alpha, int beta) {
+    BoardMask groups[MOVE_GROUP_COUNT];
+    
+    if (isMaximizing) {
+        int bestScore = -1000;
+        orderMoves(board.o, board.x, empty, groups);
+        
+        for (int g = 0; g < MOVE_GROUP_COUNT; g++) {
+            for (BoardMask group = groups[g]; group; group &= group - 1) {
+                BoardMask bit = group & -group;
+                board.o |= bit;
+                int score = minimax(depth + 1, false, alpha, beta);
+                board.o &= ~bit;
+                bestScore = max(score, bestScore);
+                alpha = max(alpha, bestScore);
+                if (alpha >= beta) return bestScore;
+            }
+        }
+        
+        return bestScore;
+    } else {
+        int bestScore = 1000;
+        orderMoves(board.x, board.o, empty, groups);
+        
+        for (int g = 0; g < MOVE_GROUP_COUNT; g++) {
+            for (BoardMask group = groups[g]; group; group &= group - 1) {
+                BoardMask bit = group & -group;
+                board.x |= bit;
+                int score = minimax(depth + 1, true, alpha, beta);
+                board.x &= ~bit;
+                bestScore = min(score, bestScore);
+                beta = min(beta, bestScore);
+                if (alpha >= beta) return bestScore;
+            }
+        }
+        
+        return bestScore;
+    }
+}
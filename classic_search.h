@@ -0,0 +1,33 @@
+#pragma once
+
+#include "bitboard.h"
+#include "transposition.h"
+
+// Alpha-beta minimax over the 3x3 board with a symmetry-aware
+// transposition table that persists between calls. It picks the same
+// cell as the perfect-play table in every position O can face, but the
+// table's static_assert checks against its own full-width minimax, not
+// this search. The game answers from the table; only the benchmarks
+// (bench/bench.cpp) still run ClassicSearch.
+// One instance per thread: the board being searched is member state.
+class ClassicSearch {
+public:
+    ClassicSearch();
+
+    // Best cell for O, ties going to the earliest cell; -1 once the game is over
+    int bestMove(const Bitboard& position);
+    // Minimax value from O's point of view, wins scored 10 minus their depth
+    int solve(const Bitboard& position, bool oToMove);
+
+    void clearTable() { table.clear(); }
+    unsigned long long nodes() const { return nodeCount; }
+    double hitRate() const { return table.hitRate(); }
+
+private:
+    Bitboard board;
+    TranspositionTable table;
+    unsigned long long nodeCount;
+
+    int minimax(int depth, bool isMaximizing, int alpha, int beta);
+    int searchChildren(int depth, bool isMaximizing, BoardMask empty, int alpha, int beta);
+};
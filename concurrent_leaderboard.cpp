@@ -0,0 +1,93 @@
+#include "concurrent_leaderboard.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+ConcurrentLeaderboard::ConcurrentLeaderboard(LeaderboardStore& store, int stripes, int flushIntervalMs)
+    : store(store), batches(max(1, stripes)), stopping(false),
+      intervalMs(max(1, flushIntervalMs)) {
+    for (int i = 0; i < max(1, stripes); i++) {
+        this->stripes.push_back(unique_ptr<Stripe>(new Stripe()));
+    }
+    flusher = thread(&ConcurrentLeaderboard::flusherLoop, this);
+}
+
+ConcurrentLeaderboard::~ConcurrentLeaderboard() {
+    {
+        lock_guard<mutex> guard(flusherLock);
+        stopping = true;
+    }
+    wake.notify_one();
+    flusher.join();
+    flush();
+}
+
+bool ConcurrentLeaderboard::record(const string& name, GameOutcome outcome) {
+    if (name.empty() || name.size() > static_cast<size_t>(MAX_NAME_LENGTH)) {
+        return false;
+    }
+    Stripe& stripe = *stripes[hash<string>()(name) % stripes.size()];
+    lock_guard<mutex> guard(stripe.lock);
+    CountMap::iterator entry = stripe.pending.find(name);
+    if (entry == stripe.pending.end()) {
+        entry = stripe.pending.insert(make_pair(name, Counts{0, 0, 0})).first;
+    }
+    Counts& counts = entry->second;
+    switch (outcome) {
+        case GameOutcome::WIN: counts.wins++; break;
+        case GameOutcome::LOSS: counts.losses++; break;
+        case GameOutcome::DRAW: counts.draws++; break;
+    }
+    return true;
+}
+
+bool ConcurrentLeaderboard::flush() {
+    lock_guard<mutex> guard(storeLock);
+    bool applied = applyPending();
+    store.flush();
+    return applied;
+}
+
+// Wake every interval, or early to stop
+void ConcurrentLeaderboard::flusherLoop() {
+    unique_lock<mutex> guard(flusherLock);
+    while (!stopping) {
+        wake.wait_for(guard, chrono::milliseconds(intervalMs), [this] { return stopping; });
+        if (stopping) {
+            break;
+        }
+        guard.unlock();
+        flush();
+        guard.lock();
+    }
+}
+
+// Swap each stripe's counts out under its lock, so recording threads wait
+// only for a pointer swap, then add them to the store. Called with
+// storeLock held.
+bool ConcurrentLeaderboard::applyPending() {
+    bool applied = true;
+    for (size_t i = 0; i < stripes.size(); i++) {
+        CountMap& batch = batches[i];
+        {
+            lock_guard<mutex> guard(stripes[i]->lock);
+            if (stripes[i]->pending.empty()) {
+                continue;
+            }
+            batch.swap(stripes[i]->pending);
+        }
+        for (CountMap::const_iterator entry = batch.begin(); entry != batch.end(); ++entry) {
+            const Counts& counts = entry->second;
+            int player = store.addPlayer(entry->first);
+            if (player < 0) {
+                applied = false;
+                continue;
+            }
+            store.addResults(player, counts.wins, counts.losses, counts.draws);
+        }
+        // Keeps its buckets for the next time it is swapped in
+        batch.clear();
+    }
+    return applied;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "leaderboard_store.h"
+
+// Lets any number of game threads report results into one
+// LeaderboardStore. Results are counted in memory, in one of many stripes
+// chosen by a hash of the player's name, each with its own lock, so
+// threads finishing games at the same time rarely wait for each other.
+// A background thread moves the counts into the store in batches and asks
+// the OS to write the file back; it is the only thread touching the store
+// while this object is in use.
+class ConcurrentLeaderboard {
+public:
+    static const int DEFAULT_STRIPES = 64;
+    static const int DEFAULT_FLUSH_INTERVAL_MS = 100;
+
+    ConcurrentLeaderboard(LeaderboardStore& store, int stripes = DEFAULT_STRIPES,
+                          int flushIntervalMs = DEFAULT_FLUSH_INTERVAL_MS);
+    // Applies whatever is still pending
+    ~ConcurrentLeaderboard();
+
+    // Count one game for a player, adding the player if needed; safe from
+    // any thread. False if the name is empty or too long.
+    bool record(const std::string& name, GameOutcome outcome);
+    // Move every result recorded so far into the store and start writing
+    // it back; false if some players could not be added
+    bool flush();
+
+    int stripeCount() const { return static_cast<int>(stripes.size()); }
+
+private:
+    struct Counts {
+        int wins;
+        int losses;
+        int draws;
+    };
+
+    typedef std::unordered_map<std::string, Counts> CountMap;
+
+    struct Stripe {
+        std::mutex lock;
+        CountMap pending;
+        char padding[64];       // keeps neighbouring stripes' locks apart
+    };
+
+    LeaderboardStore& store;
+    std::vector<std::unique_ptr<Stripe> > stripes;
+    std::vector<CountMap> batches;      // one per stripe, reused between flushes
+    std::mutex storeLock;               // the flusher and flush() take turns
+
+    std::thread flusher;
+    std::mutex flusherLock;
+    std::condition_variable wake;
+    bool stopping;
+    int intervalMs;
+
+    void flusherLoop();
+    bool applyPending();
+};
@@ -0,0 +1,538 @@
+#include "engine.h"
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+const int INFINITE_SCORE = WIN_SCORE + 1;
+const int TABLE_BITS = 18;
+
+// Value of an open line (no enemy piece in it) by how many pieces it holds
+const int LINE_WEIGHT[MAX_BOARD_SIZE + 1] = {0, 1, 4, 16, 64, 256, 1024, 4096, 16384};
+
+inline int lowestBit(GridMask mask) {
+    return __builtin_ctzll(mask);
+}
+
+inline int bitCount(GridMask mask) {
+    return __builtin_popcountll(mask);
+}
+
+// splitmix64, so the hash keys are the same on every run
+uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Mate scores are stored relative to the node so they stay valid at any ply
+int toTable(int score, int ply) {
+    if (score >= WIN_THRESHOLD) return score + ply;
+    if (score <= -WIN_THRESHOLD) return score - ply;
+    return score;
+}
+
+int fromTable(int score, int ply) {
+    if (score >= WIN_THRESHOLD) return score - ply;
+    if (score <= -WIN_THRESHOLD) return score + ply;
+    return score;
+}
+
+}
+
+BoardGeometry::BoardGeometry(int size, int winLength, int layers)
+    : size(size), winLength(winLength), layers(layers), cellTotal(layers * size * size), full(0),
+      linesThrough(layers * size * size), lineIndicesThrough(layers * size * size), notLeftColumn(0),
+      notRightColumn(0), notTopRow(0), notBottomRow(0) {
+    for (int cell = 0; cell < cellTotal; cell++) {
+        full |= GridMask(1) << cell;
+        if (cell % size != 0) notLeftColumn |= GridMask(1) << cell;
+        if (cell % size != size - 1) notRightColumn |= GridMask(1) << cell;
+        if (cell / size % size != 0) notTopRow |= GridMask(1) << cell;
+        if (cell / size % size != size - 1) notBottomRow |= GridMask(1) << cell;
+    }
+
+    // Every window of winLength cells along a row, column or diagonal, then
+    // those running from layer to layer; only the first four fit on a
+    // flat board
+    const int directions[13][3] = {
+        {0, 0, 1}, {0, 1, 0}, {0, 1, 1}, {0, 1, -1},
+        {1, 0, 0}, {1, 1, 0}, {1, -1, 0}, {1, 0, 1}, {1, 0, -1},
+        {1, 1, 1}, {1, 1, -1}, {1, -1, 1}, {1, -1, -1}};
+    for (int d = 0; d < 13; d++) {
+        for (int layer = 0; layer < layers; layer++) {
+            for (int row = 0; row < size; row++) {
+                for (int col = 0; col < size; col++) {
+                    int endLayer = layer + directions[d][0] * (winLength - 1);
+                    int endRow = row + directions[d][1] * (winLength - 1);
+                    int endCol = col + directions[d][2] * (winLength - 1);
+                    if (endLayer >= layers || endRow < 0 || endRow >= size || endCol < 0 || endCol >= size) continue;
+
+                    GridMask line = 0;
+                    for (int i = 0; i < winLength; i++) {
+                        int l = layer + directions[d][0] * i;
+                        int r = row + directions[d][1] * i;
+                        int c = col + directions[d][2] * i;
+                        line |= GridMask(1) << ((l * size + r) * size + c);
+                    }
+                    lines.push_back(line);
+                    for (int cell = 0; cell < cellTotal; cell++) {
+                        if (line >> cell & 1) {
+                            linesThrough[cell].push_back(line);
+                            lineIndicesThrough[cell].push_back(static_cast<int>(lines.size()) - 1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Cells on more lines first, then closer to the middle; on 3x3 that is
+    // center, corners, edges
+    for (int cell = 0; cell < cellTotal; cell++) {
+        centerOrder.push_back(cell);
+    }
+    const BoardGeometry& self = *this;
+    stable_sort(centerOrder.begin(), centerOrder.end(), [&self](int a, int b) {
+        size_t linesA = self.linesThrough[a].size();
+        size_t linesB = self.linesThrough[b].size();
+        if (linesA != linesB) return linesA > linesB;
+        int n = self.size - 1;
+        int area = self.size * self.size;
+        int distA = abs(2 * (a / area) - (self.layers - 1)) + abs(2 * (a / self.size % self.size) - n) +
+                    abs(2 * (a % self.size) - n);
+        int distB = abs(2 * (b / area) - (self.layers - 1)) + abs(2 * (b / self.size % self.size) - n) +
+                    abs(2 * (b % self.size) - n);
+        return distA < distB;
+    });
+}
+
+const BoardGeometry& BoardGeometry::get(int size, int winLength, int layers) {
+    static mutex cacheLock;
+    static map<pair<pair<int, int>, int>, unique_ptr<BoardGeometry> > cache;
+    lock_guard<mutex> guard(cacheLock);
+    unique_ptr<BoardGeometry>& slot = cache[make_pair(make_pair(size, winLength), layers)];
+    if (!slot) {
+        slot.reset(new BoardGeometry(size, winLength, layers));
+    }
+    return *slot;
+}
+
+bool BoardGeometry::hasWin(GridMask mask) const {
+    for (size_t i = 0; i < lines.size(); i++) {
+        if ((mask & lines[i]) == lines[i]) return true;
+    }
+    return false;
+}
+
+bool BoardGeometry::completesLine(GridMask mask, int cell) const {
+    const vector<GridMask>& through = linesThrough[cell];
+    for (size_t i = 0; i < through.size(); i++) {
+        if ((mask & through[i]) == through[i]) return true;
+    }
+    return false;
+}
+
+GridMask BoardGeometry::winningCells(GridMask own, GridMask opponent) const {
+    GridMask cells = 0;
+    for (size_t i = 0; i < lines.size(); i++) {
+        GridMask line = lines[i];
+        if ((line & opponent) == 0 && bitCount(line & own) == winLength - 1) {
+            cells |= line & ~own;
+        }
+    }
+    return cells;
+}
+
+GridMask BoardGeometry::neighbours(GridMask occupied) const {
+    GridMask spread = occupied | ((occupied << 1) & notLeftColumn) | ((occupied >> 1) & notRightColumn);
+    spread |= ((spread << size) & notTopRow) | ((spread >> size) & notBottomRow);
+    if (layers > 1) {
+        int area = size * size;
+        spread |= (spread << area) | (spread >> area);
+    }
+    return spread & full & ~occupied;
+}
+
+SearchEngine::SearchEngine(const BoardGeometry& geometry)
+    : shape(geometry), timeUp(false), checkTime(false), stopSignal(nullptr),
+      scoredCell(-1), scoredScore(0) {
+    uint64_t seed = 0x5EEDULL + geometry.size * 31 + geometry.winLength + (geometry.layers - 1) * 977;
+    for (int side = 0; side < 2; side++) {
+        for (int cell = 0; cell < MAX_CELLS; cell++) {
+            zobrist[side][cell] = nextRandom(seed);
+        }
+    }
+    sideKey = nextRandom(seed);
+
+    for (int mine = 0; mine <= MAX_BOARD_SIZE; mine++) {
+        for (int theirs = 0; theirs <= MAX_BOARD_SIZE; theirs++) {
+            int before = theirs == 0 ? LINE_WEIGHT[mine] : (mine == 0 ? -LINE_WEIGHT[theirs] : 0);
+            int after = theirs == 0 ? LINE_WEIGHT[min(mine + 1, MAX_BOARD_SIZE)] : 0;
+            placeGain[mine][theirs] = after - before;
+        }
+    }
+    prepareWorkers(1);
+}
+
+void SearchEngine::clear() {
+    Entry empty = {0, 0, 0, NO_BOUND, -1};
+    for (size_t i = 0; i < workers.size(); i++) {
+        fill(workers[i]->table.begin(), workers[i]->table.end(), empty);
+    }
+}
+
+// Make sure there is a worker per thread, and a pool of that size when
+// searching on more than one
+void SearchEngine::prepareWorkers(int threads) {
+    Entry empty = {0, 0, 0, NO_BOUND, -1};
+    while (static_cast<int>(workers.size()) < threads) {
+        unique_ptr<Worker> worker(new Worker());
+        worker->table.assign(size_t(1) << TABLE_BITS, empty);
+        worker->nodes = 0;
+        worker->tableProbes = 0;
+        worker->tableHits = 0;
+        workers.push_back(move(worker));
+    }
+    if (threads > 1 && (!pool || pool->size() != threads)) {
+        pool.reset(new ThreadPool(threads));
+    }
+}
+
+SearchResult SearchEngine::search(const GridPosition& position, char player, const SearchLimits& limits) {
+    SearchResult result = {-1, 0, 0, 0, false, 0, 0, 0};
+
+    int side = player == 'X' ? 0 : 1;
+    GridMask own = position.cells(player);
+    GridMask opponent = position.occupied() & ~own;
+    GridMask empty = shape.full & ~position.occupied();
+    if (empty == 0 || shape.hasWin(own) || shape.hasWin(opponent)) {
+        return result;
+    }
+
+    uint64_t hash = 0;
+    for (GridMask m = position.x; m; m &= m - 1) hash ^= zobrist[0][lowestBit(m)];
+    for (GridMask m = position.o; m; m &= m - 1) hash ^= zobrist[1][lowestBit(m)];
+
+    int threads = max(1, min(limits.threads, MAX_SEARCH_THREADS));
+    prepareWorkers(threads);
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i]->nodes = 0;
+        workers[i]->tableProbes = 0;
+        workers[i]->tableHits = 0;
+        setUpLines(*workers[i], position.x, position.o);
+    }
+    timeUp = false;
+    checkTime = false;
+    stopSignal = limits.stop;
+    scoredCell = limits.scoreMove;
+    scoredScore = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    deadline = start + chrono::milliseconds(limits.timeBudgetMs);
+
+    int remaining = bitCount(empty);
+    int maxDepth = min(limits.maxDepth, remaining);
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        int cell = -1;
+        int score = threads > 1 ? parallelRootSearch(own, opponent, hash, side, depth, cell)
+                                : rootSearch(own, opponent, hash, side, depth, cell);
+        if (timeUp) {
+            // Stopped from outside before any iteration finished: take the
+            // best root move searched so far, or the first in move order
+            if (result.cell < 0) {
+                int moves[MAX_CELLS];
+                orderMoves(own, opponent, -1, moves);
+                result.cell = cell >= 0 ? cell : moves[0];
+            }
+            break;
+        }
+
+        result.cell = cell;
+        result.score = score;
+        result.depth = depth;
+        result.moveScore = scoredScore;
+        // A forced result only ends the search once its distance fits in the
+        // depth just searched; cached entries from deeper searches can report
+        // longer wins before every move has been looked at that deep
+        result.complete = depth == remaining ||
+                          (abs(score) >= WIN_THRESHOLD && WIN_SCORE - abs(score) <= depth);
+        if (result.complete) break;
+
+        // The first iteration always finishes so there is a move to play;
+        // later ones stop at the deadline, and one that would likely not
+        // finish in the time left is not started
+        checkTime = true;
+        if (chrono::steady_clock::now() - start >= chrono::milliseconds(limits.timeBudgetMs) / 2) break;
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        result.nodes += workers[i]->nodes;
+        result.tableProbes += workers[i]->tableProbes;
+        result.tableHits += workers[i]->tableHits;
+    }
+    return result;
+}
+
+// Search every root move. Ties go to the cell earliest in row-major order,
+// which keeps 3x3 answers identical to the perfect-play table. The scored
+// cell, if any, is searched with a full window so its score is exact.
+int SearchEngine::rootSearch(GridMask own, GridMask opponent, uint64_t hash, int side, int depth, int& bestCell) {
+    Worker& worker = *workers[0];
+    uint64_t key = hash ^ (side ? sideKey : 0);
+    Entry& entry = worker.table[key & (worker.table.size() - 1)];
+    int firstMove = entry.key == key ? entry.move : -1;
+
+    int moves[MAX_CELLS];
+    int count = orderMoves(own, opponent, firstMove, moves);
+
+    int bestScore = -INFINITE_SCORE;
+    bestCell = -1;
+    for (int i = 0; i < count; i++) {
+        int cell = moves[i];
+        int alpha = (bestCell >= 0 && cell < bestCell) ? bestScore - 1 : bestScore;
+        int window = cell == scoredCell ? -INFINITE_SCORE : alpha;
+        int score = searchRootMove(worker, own, opponent, hash, side, depth, cell, window);
+        if (timeUp) return bestScore;
+        if (cell == scoredCell) scoredScore = score;
+
+        if (score > alpha) {
+            bestScore = score;
+            bestCell = cell;
+        }
+    }
+
+    Entry stored = {key, toTable(bestScore, 0), static_cast<int8_t>(depth), EXACT, static_cast<int8_t>(bestCell)};
+    entry = stored;
+    return bestScore;
+}
+
+// The same root search with the moves after the first shared out over the
+// pool. The first move is searched alone so the others start with a real
+// bound. Each task takes the best score so far as its alpha; a move that
+// fails low under it cannot be the answer whatever finishes later, and one
+// that beats it gets its exact score, so the pick matches rootSearch.
+int SearchEngine::parallelRootSearch(GridMask own, GridMask opponent, uint64_t hash, int side, int depth,
+                                     int& bestCell) {
+    Worker& main = *workers[0];
+    uint64_t key = hash ^ (side ? sideKey : 0);
+    Entry& entry = main.table[key & (main.table.size() - 1)];
+    int firstMove = entry.key == key ? entry.move : -1;
+
+    int moves[MAX_CELLS];
+    int count = orderMoves(own, opponent, firstMove, moves);
+
+    int bestScore = searchRootMove(main, own, opponent, hash, side, depth, moves[0], -INFINITE_SCORE);
+    bestCell = moves[0];
+    if (timeUp) return bestScore;
+    if (bestCell == scoredCell) scoredScore = bestScore;
+
+    mutex bestLock;
+    vector<ThreadPool::Task> tasks;
+    for (int i = 1; i < count; i++) {
+        int cell = moves[i];
+        tasks.push_back([&, cell](int index) {
+            int alpha;
+            {
+                lock_guard<mutex> guard(bestLock);
+                alpha = cell < bestCell ? bestScore - 1 : bestScore;
+            }
+            int window = cell == scoredCell ? -INFINITE_SCORE : alpha;
+            int score = searchRootMove(*workers[index], own, opponent, hash, side, depth, cell, window);
+            if (timeUp) return;
+            if (cell == scoredCell) scoredScore = score;    // no other task has this cell
+            if (score <= alpha) return;
+
+            lock_guard<mutex> guard(bestLock);
+            if (score > bestScore || (score == bestScore && cell < bestCell)) {
+                bestScore = score;
+                bestCell = cell;
+            }
+        });
+    }
+    pool->run(tasks);
+    if (timeUp) return bestScore;
+
+    Entry stored = {key, toTable(bestScore, 0), static_cast<int8_t>(depth), EXACT, static_cast<int8_t>(bestCell)};
+    entry = stored;
+    return bestScore;
+}
+
+// Score of one root move for the side to move: exact when above alpha,
+// otherwise only known to be at most alpha
+int SearchEngine::searchRootMove(Worker& worker, GridMask own, GridMask opponent, uint64_t hash, int side,
+                                 int depth, int cell, int alpha) {
+    GridMask bit = GridMask(1) << cell;
+    int score;
+    if (makeMove(worker, side, cell)) {
+        score = WIN_SCORE - 1;
+    } else if ((own | opponent | bit) == shape.full) {
+        score = 0;
+    } else {
+        score = -negamax(worker, opponent, own | bit, hash ^ zobrist[side][cell], 1 - side,
+                         depth - 1, 1, -INFINITE_SCORE, -alpha);
+    }
+    unmakeMove(worker, side, cell);
+    return score;
+}
+
+// Negamax alpha-beta from the point of view of the side to move (`own`).
+// The previous move is known not to have ended the game.
+int SearchEngine::negamax(Worker& worker, GridMask own, GridMask opponent, uint64_t hash, int side,
+                          int depth, int ply, int alpha, int beta) {
+    worker.nodes++;
+    if ((worker.nodes & 2047) == 0) {
+        if (checkTime && chrono::steady_clock::now() >= deadline) timeUp = true;
+        if (stopSignal && stopSignal->due()) timeUp = true;
+    }
+    if (timeUp) return 0;
+
+    if (depth == 0) {
+        return evaluate(worker, side);
+    }
+
+    uint64_t key = hash ^ (side ? sideKey : 0);
+    Entry& entry = worker.table[key & (worker.table.size() - 1)];
+    int firstMove = -1;
+    worker.tableProbes++;
+    if (entry.key == key && entry.bound != NO_BOUND) {
+        worker.tableHits++;
+        firstMove = entry.move;
+        // Only a score searched to exactly this depth may cut: then a score
+        // depends on the position and depth alone, not on what a table has
+        // seen before, and every thread agrees on it
+        if (entry.depth == depth) {
+            int score = fromTable(entry.score, ply);
+            if (entry.bound == EXACT ||
+                (entry.bound == LOWER && score >= beta) ||
+                (entry.bound == UPPER && score <= alpha)) {
+                return score;
+            }
+        }
+    }
+
+    int moves[MAX_CELLS];
+    int count = orderMoves(own, opponent, firstMove, moves);
+
+    int alphaOriginal = alpha;
+    int bestScore = -INFINITE_SCORE;
+    int bestCell = -1;
+    for (int i = 0; i < count; i++) {
+        int cell = moves[i];
+        GridMask bit = GridMask(1) << cell;
+
+        int score;
+        if (makeMove(worker, side, cell)) {
+            score = WIN_SCORE - ply - 1;
+        } else if ((own | opponent | bit) == shape.full) {
+            score = 0;
+        } else {
+            score = -negamax(worker, opponent, own | bit, hash ^ zobrist[side][cell], 1 - side,
+                             depth - 1, ply + 1, -beta, -alpha);
+        }
+        unmakeMove(worker, side, cell);
+        if (timeUp) return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestCell = cell;
+        }
+        if (bestScore > alpha) alpha = bestScore;
+        if (alpha >= beta) break;
+    }
+
+    Bound bound = EXACT;
+    if (bestScore <= alphaOriginal) bound = UPPER;
+    else if (bestScore >= beta) bound = LOWER;
+    Entry stored = {key, toTable(bestScore, ply), static_cast<int8_t>(depth), bound, static_cast<int8_t>(bestCell)};
+    entry = stored;
+    return bestScore;
+}
+
+// Count the pieces in every line of the root position from scratch
+void SearchEngine::setUpLines(Worker& worker, GridMask x, GridMask o) const {
+    size_t lineTotal = shape.lines.size();
+    worker.linePieces[0].assign(lineTotal, 0);
+    worker.linePieces[1].assign(lineTotal, 0);
+    worker.lineScore = 0;
+    for (size_t i = 0; i < lineTotal; i++) {
+        int xs = bitCount(shape.lines[i] & x);
+        int os = bitCount(shape.lines[i] & o);
+        worker.linePieces[0][i] = static_cast<uint8_t>(xs);
+        worker.linePieces[1][i] = static_cast<uint8_t>(os);
+        if (os == 0) worker.lineScore += LINE_WEIGHT[xs];
+        else if (xs == 0) worker.lineScore -= LINE_WEIGHT[os];
+    }
+}
+
+// Add a piece to the lines through `cell`; true if one of them is now full
+bool SearchEngine::makeMove(Worker& worker, int side, int cell) const {
+    const vector<int>& through = shape.lineIndicesThrough[cell];
+    uint8_t* mine = worker.linePieces[side].data();
+    const uint8_t* theirs = worker.linePieces[1 - side].data();
+    int gain = 0;
+    bool won = false;
+    for (size_t i = 0; i < through.size(); i++) {
+        int line = through[i];
+        gain += placeGain[mine[line]][theirs[line]];
+        won |= ++mine[line] == shape.winLength;
+    }
+    worker.lineScore += side == 0 ? gain : -gain;
+    return won;
+}
+
+// Take back the piece makeMove added
+void SearchEngine::unmakeMove(Worker& worker, int side, int cell) const {
+    const vector<int>& through = shape.lineIndicesThrough[cell];
+    uint8_t* mine = worker.linePieces[side].data();
+    const uint8_t* theirs = worker.linePieces[1 - side].data();
+    int gain = 0;
+    for (size_t i = 0; i < through.size(); i++) {
+        int line = through[i];
+        gain += placeGain[--mine[line]][theirs[line]];
+    }
+    worker.lineScore -= side == 0 ? gain : -gain;
+}
+
+// Open lines for the side to move minus open lines for the opponent, each
+// weighted by how many pieces it already holds, so lines one piece short
+// of a win count for far more than fresh ones
+int SearchEngine::evaluate(const Worker& worker, int side) const {
+    return side == 0 ? worker.lineScore : -worker.lineScore;
+}
+
+// Moves in search order: the cached best move, winning moves, blocking
+// moves, then the rest from the middle outwards. On boards larger than
+// 3x3 only cells next to existing pieces are considered.
+int SearchEngine::orderMoves(GridMask own, GridMask opponent, int firstMove, int moves[]) const {
+    GridMask occupied = own | opponent;
+    GridMask candidates = shape.full & ~occupied;
+    if (shape.size > 3 && occupied != 0) {
+        GridMask near = shape.neighbours(occupied);
+        if (near != 0) candidates = near;
+    }
+
+    GridMask wins = shape.winningCells(own, opponent) & ~occupied;
+    GridMask blocks = shape.winningCells(opponent, own) & ~occupied & ~wins;
+    GridMask rest = candidates & ~(wins | blocks);
+
+    int count = 0;
+    GridMask taken = 0;
+    if (firstMove >= 0 && ((wins | blocks | rest) >> firstMove & 1)) {
+        moves[count++] = firstMove;
+        taken = GridMask(1) << firstMove;
+    }
+    for (GridMask m = wins & ~taken; m; m &= m - 1) moves[count++] = lowestBit(m);
+    for (GridMask m = blocks & ~taken; m; m &= m - 1) moves[count++] = lowestBit(m);
+    for (size_t i = 0; i < shape.centerOrder.size(); i++) {
+        int cell = shape.centerOrder[i];
+        if (((rest & ~taken) >> cell) & 1) moves[count++] = cell;
+    }
+    return count;
+}
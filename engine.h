@@ -0,0 +1,194 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "thread_pool.h"
+
+// One bit per cell, cell index = (layer * size + row) * size + col; boards
+// up to 8x8, or 4x4x4, fit
+typedef uint64_t GridMask;
+
+const int MAX_BOARD_SIZE = 8;
+const int MAX_CELLS = MAX_BOARD_SIZE * MAX_BOARD_SIZE;
+const int MAX_SEARCH_THREADS = 64;
+
+// Scores at or beyond this magnitude are forced wins or losses
+const int WIN_SCORE = 100000000;
+const int WIN_THRESHOLD = WIN_SCORE - 1000;
+
+// Board size, win length and every winning window of one game variant.
+// A board with more than one layer is a cube of size x size layers, where
+// lines also run between layers and along the space diagonals.
+class BoardGeometry {
+public:
+    int size;
+    int winLength;
+    int layers;                 // 1 for a flat board
+    int cellTotal;
+    GridMask full;
+    std::vector<GridMask> lines;
+    std::vector<std::vector<GridMask> > linesThrough;
+    std::vector<std::vector<int> > lineIndicesThrough;     // positions in `lines`
+    std::vector<int> centerOrder;
+
+    BoardGeometry(int size, int winLength, int layers = 1);
+
+    // Shared instance per variant, built on first use; safe from any thread
+    static const BoardGeometry& get(int size, int winLength, int layers = 1);
+
+    bool hasWin(GridMask mask) const;
+    // Faster check when the only new piece is at `cell`
+    bool completesLine(GridMask mask, int cell) const;
+    // Empty cells that would complete a line for the owner of `own`
+    GridMask winningCells(GridMask own, GridMask opponent) const;
+    // Empty cells next to any piece, including diagonally
+    GridMask neighbours(GridMask occupied) const;
+
+private:
+    GridMask notLeftColumn;
+    GridMask notRightColumn;
+    GridMask notTopRow;
+    GridMask notBottomRow;
+};
+
+// N x N position stored as one bitmask per side
+struct GridPosition {
+    GridMask x;
+    GridMask o;
+
+    GridPosition() : x(0), o(0) {}
+
+    GridMask occupied() const { return x | o; }
+    GridMask cells(char player) const { return player == 'X' ? x : o; }
+    bool isEmpty(int cell) const { return (occupied() >> cell & 1) == 0; }
+
+    char at(int cell) const {
+        if (x >> cell & 1) return 'X';
+        if (o >> cell & 1) return 'O';
+        return ' ';
+    }
+
+    void place(int cell, char player) {
+        if (player == 'X') {
+            x |= GridMask(1) << cell;
+        } else {
+            o |= GridMask(1) << cell;
+        }
+    }
+};
+
+// Lets whoever asked for a move end its search from another thread: the
+// search stops soon after `stopped` is set or the deadline passes, and
+// answers with the best move it has found so far
+struct StopSignal {
+    std::atomic<bool> stopped;
+    std::chrono::steady_clock::time_point deadline;     // set before the search starts
+
+    StopSignal() : stopped(false), deadline(std::chrono::steady_clock::time_point::max()) {}
+
+    bool due() const {
+        return stopped.load(std::memory_order_relaxed) || std::chrono::steady_clock::now() >= deadline;
+    }
+};
+
+// How long and how deep one decision may search, and on how many threads
+struct SearchLimits {
+    int timeBudgetMs;           // soft: the first iteration always finishes
+    int maxDepth;
+    int threads;
+    const StopSignal* stop;     // hard limit; nullptr for none
+    int scoreMove;              // root cell whose exact score is also wanted; -1 for none
+
+    SearchLimits() : timeBudgetMs(1000), maxDepth(MAX_CELLS), threads(1), stop(nullptr), scoreMove(-1) {}
+};
+
+struct SearchResult {
+    int cell;                   // -1 if there is no legal move
+    int score;                  // from the mover's point of view
+    int depth;                  // last fully searched depth
+    unsigned long long nodes;
+    bool complete;              // searched to the end of the game
+    unsigned long long tableProbes;     // transposition table lookups
+    unsigned long long tableHits;       // lookups that found the position
+    int moveScore;              // score of limits.scoreMove at the same depth, if it is empty
+};
+
+// Iterative-deepening alpha-beta search for one board variant. Each
+// iteration goes one ply deeper until the time budget runs out, and the
+// answer of the last finished iteration is kept, so latency stays bounded
+// however large the board is.
+//
+// Positions past the search depth are scored by their open lines. Each
+// worker keeps the piece count of every line as it makes and unmakes
+// moves, so a move touches only the lines through its cell and scoring a
+// leaf takes constant time.
+//
+// With more than one thread the root moves are shared out over a
+// work-stealing pool. Each worker searches its own copy of the position
+// with its own transposition table, and every iteration picks the same
+// move the single-threaded search would.
+class SearchEngine {
+public:
+    explicit SearchEngine(const BoardGeometry& geometry);
+
+    const BoardGeometry& geometry() const { return shape; }
+
+    SearchResult search(const GridPosition& position, char player, const SearchLimits& limits);
+    void clear();
+
+private:
+    enum Bound : uint8_t { NO_BOUND, EXACT, LOWER, UPPER };
+
+    struct Entry {
+        uint64_t key;
+        int32_t score;
+        int8_t depth;
+        Bound bound;
+        int8_t move;
+    };
+
+    // What each search thread keeps to itself; worker 0 also serves the
+    // single-threaded search and holds the root entries
+    struct Worker {
+        std::vector<Entry> table;
+        unsigned long long nodes;
+        unsigned long long tableProbes;
+        unsigned long long tableHits;
+        // Pieces of each side in every line, and the evaluation they add up
+        // to from X's point of view, kept in step with the searched position
+        std::vector<uint8_t> linePieces[2];
+        int lineScore;
+    };
+
+    const BoardGeometry& shape;
+    std::vector<std::unique_ptr<Worker> > workers;
+    std::unique_ptr<ThreadPool> pool;
+    uint64_t zobrist[2][MAX_CELLS];
+    uint64_t sideKey;
+    // Change in a line's value for the side adding a piece to it, by the
+    // pieces each side already has there
+    int placeGain[MAX_BOARD_SIZE + 1][MAX_BOARD_SIZE + 1];
+
+    std::atomic<bool> timeUp;
+    bool checkTime;
+    const StopSignal* stopSignal;
+    std::chrono::steady_clock::time_point deadline;
+    int scoredCell;             // searched with a full window at the root
+    int scoredScore;
+
+    void prepareWorkers(int threads);
+    int rootSearch(GridMask own, GridMask opponent, uint64_t hash, int side, int depth, int& bestCell);
+    int parallelRootSearch(GridMask own, GridMask opponent, uint64_t hash, int side, int depth, int& bestCell);
+    int searchRootMove(Worker& worker, GridMask own, GridMask opponent, uint64_t hash, int side,
+                       int depth, int cell, int alpha);
+    int negamax(Worker& worker, GridMask own, GridMask opponent, uint64_t hash, int side,
+                int depth, int ply, int alpha, int beta);
+    void setUpLines(Worker& worker, GridMask x, GridMask o) const;
+    bool makeMove(Worker& worker, int side, int cell) const;
+    void unmakeMove(Worker& worker, int side, int cell) const;
+    int evaluate(const Worker& worker, int side) const;
+    int orderMoves(GridMask own, GridMask opponent, int firstMove, int moves[]) const;
+};
@@ -1,73 +1,80 @@
 #include <iostream>
-#include <fstream>
+#include <chrono>
+#include <cstdlib>
 #include <iomanip>
 #include <limits>
 #include <algorithm>
 #include <cctype>
 #include <locale>
+#include <thread>
+#include <vector>
 #include "game.h"
 
 using namespace std;
 
+// Win length of the flat board variant of this size, or the size itself
+int defaultWinLength(int size) {
+    for (int v = 0; v < BOARD_VARIANT_COUNT; v++) {
+        if (BOARD_VARIANTS[v].size == size && BOARD_VARIANTS[v].layers == 1) {
+            return BOARD_VARIANTS[v].winLength;
+        }
+    }
+    return size;
+}
+
 // Constructor: Initialize game state
-Game::Game() : currentPlayer(PLAYER_X), vsAI(false), aiDifficulty(Difficulty::MEDIUM) {
+Game::Game(const string& leaderboardFile, const string& gameLogFile)
+    : geometry(nullptr), currentPlayer(PLAYER_X), vsAI(false), aiDifficulty(Difficulty::MEDIUM),
+      searchNodes(0), searchDepth(0), aiDelayMs(DEFAULT_AI_DELAY_MS),
+      aiDeadlineMs(DEFAULT_AI_DEADLINE_MS), searchPlayouts(0), leaderboard(leaderboardFile),
+      gameLog(gameLogFile) {
+    aiSettings.threads = max(1, static_cast<int>(thread::hardware_concurrency()));
+    setPolicyFile(MEDIUM_POLICY_FILE);
+    selectBoard(BOARD_SIZE, BOARD_SIZE);
     initializeBoard();
     loadLeaderboard();
+    if (!gameLog.open()) {
+        cout << "Warning: could not open " << gameLog.path() << "; games will not be logged.\n";
+    }
+}
+
+// Destructor: write the leaderboard back, then the statistics, on the way out
+Game::~Game() {
+    saveLeaderboard();
+    if (!statsFile.empty() && !stats.writeJson(statsFile)) {
+        cout << "Warning: could not write statistics to " << statsFile << "\n";
+    }
 }
 
 // Initialize the game board with empty spaces
 void Game::initializeBoard() {
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            board[i][j] = EMPTY;
-        }
-    }
+    board = GridPosition();
+}
+
+// Switch to an N x N board (or an N x N x N cube) with K in a row to win
+void Game::selectBoard(int size, int winLength, int layers) {
+    geometry = &BoardGeometry::get(size, winLength, layers);
+}
+
+// The board as the engine library sees it, with the given side to move
+Position Game::currentPosition(char toMove) const {
+    Position position(*geometry, toMove);
+    position.cells = board;
+    return position;
 }
 
 // Clear the console screen
 void Game::clearScreen() const {
-    #ifdef _WIN32
-        system("cls");
-    #else
-        system("clear");
-    #endif
+    screen.clear();
 }
 
 // Display the game board with visual enhancements
-void Game::displayBoard() const {
-    cout << "\n        1       2       3\n";
-    cout << "    +-------+-------+-------+\n";
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        // Top padding inside each row
-        cout << "    |       |       |       |\n";
-
-        // Middle row with symbols
-        cout << " " << i+1 << "  |";
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            char cell = board[i][j];
-            if (cell == PLAYER_X) {
-                cout << "   \033[1;34m" << cell << "\033[0m   |";
-            } else if (cell == PLAYER_O) {
-                cout << "   \033[1;31m" << cell << "\033[0m   |";
-            } else {
-                cout << "       |";
-            }
-        }
-        cout << "\n";
-
-        // Bottom padding inside each row
-        cout << "    |       |       |       |\n";
-
-        // Row separator
-        if (i < BOARD_SIZE - 1) {
-            cout << "    +-------+-------+-------+\n";
-        }
-    }
-    cout << "    +-------+-------+-------+\n\n";
+void Game::displayBoard(const string& status) const {
+    screen.drawBoard(board, geometry->size, geometry->layers, status);
 }
 
 // Display current game status
-void Game::displayStatus() const {
+string Game::statusLine() const {
     string currentPlayerName;
     if (currentPlayer == PLAYER_X) {
         currentPlayerName = player1Name;
@@ -75,48 +82,32 @@ void Game::displayStatus() const {
         currentPlayerName = vsAI ? "AI" : player2Name;
     }
     
-    cout << "Current player: " << currentPlayerName << " (" << currentPlayer << ")\n";
+    return "Current player: " + currentPlayerName + " (" + currentPlayer + ")\n";
 }
 
 // Check if a move is valid
-bool Game::isValidMove(int row, int col) const {
-    return (row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE && board[row][col] == EMPTY);
+bool Game::isValidMove(int row, int col, int layer) const {
+    int size = geometry->size;
+    return (layer >= 0 && layer < geometry->layers && row >= 0 && row < size && col >= 0 && col < size &&
+            board.isEmpty((layer * size + row) * size + col));
 }
 
 // Make a move on the board
-void Game::makeMove(int row, int col) {
-    board[row][col] = currentPlayer;
+void Game::makeMove(int row, int col, int layer) {
+    int cell = (layer * geometry->size + row) * geometry->size + col;
+    board.place(cell, currentPlayer);
+    gameRecord.moves[gameRecord.moveCount++] = static_cast<uint8_t>(cell);
 }
 
 // Check if a player has won
 bool Game::checkWin(char player) const {
-    // Check rows and columns
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        if ((board[i][0] == player && board[i][1] == player && board[i][2] == player) ||
-            (board[0][i] == player && board[1][i] == player && board[2][i] == player)) {
-            return true;
-        }
-    }
-    
-    // Check diagonals
-    if ((board[0][0] == player && board[1][1] == player && board[2][2] == player) ||
-        (board[0][2] == player && board[1][1] == player && board[2][0] == player)) {
-        return true;
-    }
-    
-    return false;
+    // Every row, column and diagonal window is a precomputed mask
+    return geometry->hasWin(board.cells(player));
 }
 
 // Check if the game is a draw
 bool Game::checkDraw() const {
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            if (board[i][j] == EMPTY) {
-                return false;
-            }
-        }
-    }
-    return true;
+    return board.occupied() == geometry->full;
 }
 
 // Switch to the other player
@@ -217,7 +208,8 @@ void Game::showMainMenu() const {
 	cout << "         2. Player vs AI\n";
     cout << "         3. View Leaderboard\n";
 	cout << "         4. Help & Instructions\n";
-    cout << "         5. Exit\n";
+    cout << "         5. Statistics\n";
+	cout << "         6. Exit\n";
     cout << "========================================\n";
 }
 
@@ -230,36 +222,39 @@ void Game::startNewGame(bool againstAI) {
     // Get player names
     if (player1Name.empty()) {
         player1Name = getPlayerName("Enter Player 1 (X) name: ");
-        if (leaderboard.find(player1Name) == leaderboard.end()) {
-            leaderboard[player1Name] = {player1Name, 0, 0, 0};
-        }
+        addToLeaderboard(player1Name);
     }
     
+    // Select the board
+    int boardChoice = getValidatedInput("Select board (1-3x3, 2-5x5 four in a row, 3-7x7 five in a row, "
+                                        "4-4x4x4 cube): ", 1, BOARD_VARIANT_COUNT);
+    const BoardVariant& variant = BOARD_VARIANTS[boardChoice - 1];
+    selectBoard(variant.size, variant.winLength, variant.layers);
+    gameRecord = GameRecord();
+    gameRecord.boardSize = static_cast<uint8_t>(geometry->size);
+    gameRecord.winLength = static_cast<uint8_t>(geometry->winLength);
+    gameRecord.layers = static_cast<uint8_t>(geometry->layers);
+    
     if (againstAI) {
         player2Name = "AI";
         // Select AI difficulty
-        int diffChoice = getValidatedInput("Select AI difficulty (1-Easy, 2-Medium, 3-Hard): ", 1, 3);
+        int diffChoice = getValidatedInput("Select AI difficulty (1-Easy, 2-Medium, 3-Hard, 4-Monte Carlo): ", 1, 4);
         
         if (diffChoice == 1) aiDifficulty = Difficulty::EASY;
         else if (diffChoice == 3) aiDifficulty = Difficulty::HARD;
+        else if (diffChoice == 4) aiDifficulty = Difficulty::MONTE_CARLO;
         else aiDifficulty = Difficulty::MEDIUM;
          // Ask who goes first
 	    int firstChoice = getValidatedInput("Who goes first? (1-You, 2-AI): ", 1, 2);
 	    if (firstChoice == 2) {
 	        currentPlayer = PLAYER_O; // AI will move first
+	        gameRecord.firstPlayer = PLAYER_O;
 	    } else {
 	        currentPlayer = PLAYER_X; // Player starts
 	    }
 	    // If AI goes first, show board once before AI moves
 		if (vsAI && currentPlayer == PLAYER_O) {
-		    clearScreen();
-		    displayBoard();
-		    cout << "AI is thinking...\n";
-		    #ifdef _WIN32
-		        system("timeout 1 >nul"); // 1 second pause on Windows
-		    #else
-		        system("sleep 1");        // 1 second pause on Linux/Mac
-		    #endif
+		    displayBoard("AI is thinking...\n");
 		    makeAIMove();
 		    switchPlayer(); // After AI moves, switch to player
 		}
@@ -267,49 +262,45 @@ void Game::startNewGame(bool againstAI) {
         if (player2Name.empty() || player2Name == "AI") {
             player2Name = getPlayerName("Enter Player 2 (O) name: ");
         }
-        if (leaderboard.find(player2Name) == leaderboard.end()) {
-            leaderboard[player2Name] = {player2Name, 0, 0, 0};
-        }
+        addToLeaderboard(player2Name);
     }
     
     // Game loop
     bool gameOver = false;
     
     while (!gameOver) {
-        clearScreen();
-        displayBoard();
-        displayStatus();
-        
         if (vsAI && currentPlayer == PLAYER_O) {
             // AI's turn
-            cout << "AI is thinking...\n";
-            #ifdef _WIN32
-                system("timeout 1 >nul");
-            #else
-                system("sleep 1");
-            #endif
+            displayBoard(statusLine() + "AI is thinking...\n");
             makeAIMove();
         } else {
-            // Player's turn
-            int row = getValidatedInput("Enter row (1-3): ", 1, 3);
-            int col = getValidatedInput("Enter column (1-3): ", 1, 3);
+            // Player's turn; the AI thinks about its answers meanwhile
+            if (vsAI && aiPonders()) {
+                ponderer.start(currentPosition(PLAYER_X), aiMoveOptions());
+            }
+            displayBoard(statusLine());
+            int size = geometry->size;
+            string range = "(1-" + to_string(size) + "): ";
+            int layer = geometry->layers > 1 ? getValidatedInput("Enter layer " + range, 1, size) : 1;
+            int row = getValidatedInput("Enter row " + range, 1, size);
+            int col = getValidatedInput("Enter column " + range, 1, size);
             
             // Convert to 0-based index
+            layer--;
             row--;
             col--;
             
-            if (!isValidMove(row, col)) {
+            if (!isValidMove(row, col, layer)) {
                 cout << "That position is already taken. Please try again.\n";
                 waitForEnter();
                 continue;
             }
             
-            makeMove(row, col);
+            makeMove(row, col, layer);
         }
         
         // Check for win
         if (checkWin(currentPlayer)) {
-            clearScreen();
             displayBoard();
             string winnerName = (currentPlayer == PLAYER_X) ? player1Name : player2Name;
             cout << "?? Player " << winnerName << " wins! ??\n";
@@ -326,18 +317,19 @@ void Game::startNewGame(bool againstAI) {
                 }
                 updateLeaderboard(player1Name, false);
             }
+            logGame(currentPlayer);
             
             gameOver = true;
         } 
         // Check for draw
         else if (checkDraw()) {
-            clearScreen();
             displayBoard();
             cout << "It's a draw!\n";
             
             // Update leaderboard
             updateLeaderboard(player1Name, false, true);
             if (!vsAI) updateLeaderboard(player2Name, false, true);
+            logGame('D');
             
             gameOver = true;
         } 
@@ -347,6 +339,8 @@ void Game::startNewGame(bool againstAI) {
         }
     }
     
+    ponderer.stop();
+    
     // Ask to play again
     char playAgain;
     cout << "\nWould you like to play again? (y/n): ";
@@ -355,209 +349,231 @@ void Game::startNewGame(bool againstAI) {
     
     if (tolower(playAgain) == 'y') {
         startNewGame(vsAI);
-    } else {
-        saveLeaderboard();
     }
 }
 
 // AI makes a move based on difficulty
 void Game::makeAIMove() {
-    pair<int, int> move;
-    
-    switch (aiDifficulty) {
-        case Difficulty::EASY:
-            // 70% random moves, 30% smart moves
-            if (rand() % 10 < 7) {
-                move = findRandomMove();
-            } else {
-                move = findBestMove();
-            }
-            break;
-            
-        case Difficulty::MEDIUM:
-            // Try to win, then block, then make a good move
-            move = findWinningMove(PLAYER_O);
-            if (move.first == -1) {
-                move = findWinningMove(PLAYER_X); // Block
-                if (move.first == -1) {
-                    move = findBestMove();
-                }
-            }
-            break;
-            
-        case Difficulty::HARD:
-            // Always use minimax for best move
-            move = findBestMove();
-            break;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    // Every move is searched on the ponder thread, so the search state
+    // carried between turns stays in one place
+    bool pondered = false;
+    MoveFuture pending = ponderer.answer(currentPosition(PLAYER_O), aiMoveOptions(), aiDeadlineMs, pondered);
+    AIMove choice = pending.get();
+    if (aiPonders()) {
+        stats.recordPonder(pondered);
     }
+    chrono::nanoseconds spent = chrono::steady_clock::now() - start;
+    stats.recordDecision(aiDifficulty, static_cast<uint64_t>(spent.count()), choice);
+    searchNodes = choice.nodes;
+    searchDepth = choice.depth;
+    searchPlayouts = choice.playouts;
     
-    makeMove(move.first, move.second);
-    cout << "AI chose position: " << move.first+1 << " " << move.second+1 << endl;
-}
-
-// Find the best move using minimax algorithm
-pair<int, int> Game::findBestMove() {
-    int bestScore = -1000;
-    pair<int, int> bestMove = {-1, -1};
+    // Leave the AI's turn on screen for a moment, in-process
+    this_thread::sleep_until(start + chrono::milliseconds(aiDelayMs));
     
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            if (board[i][j] == EMPTY) {
-                board[i][j] = PLAYER_O;
-                int score = minimax(0, false);
-                board[i][j] = EMPTY;
-                
-                if (score > bestScore) {
-                    bestScore = score;
-                    bestMove = {i, j};
-                }
-            }
-        }
+    int size = geometry->size;
+    int layer = choice.cell / (size * size);
+    pair<int, int> move = {choice.cell / size % size, choice.cell % size};
+    makeMove(move.first, move.second, layer);
+    cout << "AI chose position: ";
+    if (geometry->layers > 1) cout << layer + 1 << " ";
+    cout << move.first+1 << " " << move.second+1 << endl;
+    if (searchNodes > 0) {
+        cout << "Nodes searched: " << searchNodes << ", depth " << searchDepth << endl;
+    }
+    if (searchPlayouts > 0) {
+        cout << "Playouts: " << searchPlayouts << endl;
+    }
+    if (pondered) {
+        cout << "(worked out while you were thinking)" << endl;
     }
-    
-    return bestMove;
 }
 
-// Minimax algorithm for AI decision making
-int Game::minimax(int depth, bool isMaximizing) {
-    if (checkWin(PLAYER_O)) return 10 - depth;
-    if (checkWin(PLAYER_X)) return depth - 10;
-    if (checkDraw()) return 0;
-    
-    if (isMaximizing) {
-        int bestScore = -1000;
-        
-        for (int i = 0; i < BOARD_SIZE; i++) {
-            for (int j = 0; j < BOARD_SIZE; j++) {
-                if (board[i][j] == EMPTY) {
-                    board[i][j] = PLAYER_O;
-                    int score = minimax(depth + 1, false);
-                    board[i][j] = EMPTY;
-                    bestScore = max(score, bestScore);
-                }
-            }
-        }
-        
-        return bestScore;
-    } else {
-        int bestScore = 1000;
-        
-        for (int i = 0; i < BOARD_SIZE; i++) {
-            for (int j = 0; j < BOARD_SIZE; j++) {
-                if (board[i][j] == EMPTY) {
-                    board[i][j] = PLAYER_X;
-                    int score = minimax(depth + 1, true);
-                    board[i][j] = EMPTY;
-                    bestScore = min(score, bestScore);
-                }
-            }
-        }
-        
-        return bestScore;
-    }
+// What the AI is asked for, with a fresh seed for its random choices
+MoveOptions Game::aiMoveOptions() const {
+    MoveOptions options;
+    options.difficulty = aiDifficulty;
+    options.settings = aiSettings;
+    options.seed = static_cast<uint64_t>(rand()) + 1;
+    return options;
 }
 
-// Find a random valid move
-pair<int, int> Game::findRandomMove() const {
-    vector<pair<int, int>> availableMoves;
-    
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            if (board[i][j] == EMPTY) {
-                availableMoves.push_back({i, j});
-            }
-        }
-    }
-    
-    if (availableMoves.empty()) {
-        return {-1, -1};
-    }
-    
-    int randomIndex = rand() % availableMoves.size();
-    return availableMoves[randomIndex];
-}
-
-// Find a winning move for the specified player
-pair<int, int> Game::findWinningMove(char player) const {
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            if (board[i][j] == EMPTY) {
-                // Test if this move would win
-                char temp = board[i][j];
-                const_cast<Game*>(this)->board[i][j] = player;
-                bool wouldWin = checkWin(player);
-                const_cast<Game*>(this)->board[i][j] = temp;
-                
-                if (wouldWin) {
-                    return {i, j};
-                }
-            }
-        }
+// Ponder where the AI's move takes real search time: the alpha-beta
+// difficulties beyond 3x3. The Monte Carlo trees already carry over
+// between turns and 3x3 is a table lookup.
+bool Game::aiPonders() const {
+    return aiDifficulty != Difficulty::MONTE_CARLO && geometry->size > 3;
+}
+
+// Per-move thinking time for the AI on boards larger than 3x3
+void Game::setAITimeBudget(int milliseconds) {
+    aiSettings.timeBudgetMs = milliseconds;
+}
+
+// Threads the AI searches with on boards larger than 3x3; the move it
+// picks does not depend on the count
+void Game::setAIThreads(int threads) {
+    aiSettings.threads = max(1, min(threads, MAX_SEARCH_THREADS));
+}
+
+// Random games the Monte Carlo AI plays per move
+void Game::setAIPlayouts(int playouts) {
+    aiSettings.playouts = max(1, playouts);
+}
+
+// Set the shortest pause on the AI's turn (0 for none)
+void Game::setAIDelay(int milliseconds) {
+    aiDelayMs = max(0, milliseconds);
+}
+
+// Set the hard limit on the AI's thinking per move (0 for none)
+void Game::setAIDeadline(int milliseconds) {
+    aiDeadlineMs = max(0, milliseconds);
+}
+
+// Write the session statistics as JSON to this file on exit
+void Game::setStatsFile(const string& path) {
+    statsFile = path;
+}
+
+// Load Medium's table; without one Medium plays by its rules
+bool Game::setPolicyFile(const string& path) {
+    bool loaded = loadPolicyTable(path, mediumPolicy);
+    aiSettings.policy = loaded ? &mediumPolicy : nullptr;
+    return loaded;
+}
+
+// Set how closely Medium follows its table (100 always takes the best move)
+void Game::setPolicyStrength(int strength) {
+    aiSettings.policyStrength = max(0, min(strength, 100));
+}
+
+// Number of minimax nodes visited by the last AI decision
+unsigned long long Game::lastSearchNodes() const {
+    return searchNodes;
+}
+
+// Give a player a leaderboard entry if they do not have one yet
+void Game::addToLeaderboard(const string& name) {
+    int player = leaderboard.addPlayer(name);
+    if (player >= 0 && ranking.built() && ranking.rankOf(player) < 0) {
+        ranking.update(player, leaderboard.at(player));
     }
-    
-    return {-1, -1};
 }
 
 // Update the leaderboard with game results
 void Game::updateLeaderboard(const string& name, bool won, bool draw) {
-    if (leaderboard.find(name) != leaderboard.end()) {
-        if (draw) {
-            leaderboard[name].draws++;
-        } else if (won) {
-            leaderboard[name].wins++;
-        } else {
-            leaderboard[name].losses++;
+    int player = leaderboard.find(name);
+    if (player >= 0) {
+        // Rewrites this player's counters in the mapped file, nothing else,
+        // then moves the player to their new place in the ranking
+        leaderboard.record(player, draw ? GameOutcome::DRAW : won ? GameOutcome::WIN : GameOutcome::LOSS);
+        if (ranking.built()) {
+            ranking.update(player, leaderboard.at(player));
         }
-        saveLeaderboard(); // ? Save immediately after every update
     }
 }
 
-//Show the leaderboard and allow user to reset it
+// Queue the finished game for the game log: 'X', 'O' or 'D' for a draw
+void Game::logGame(char result) {
+    int x = leaderboard.find(player1Name);
+    int o = vsAI ? -1 : leaderboard.find(player2Name);
+    gameRecord.xPlayer = x >= 0 ? static_cast<uint32_t>(x) : NO_PLAYER;
+    gameRecord.oPlayer = o >= 0 ? static_cast<uint32_t>(o) : NO_PLAYER;
+    gameRecord.oLevel = static_cast<int8_t>(vsAI ? static_cast<int>(aiDifficulty) : HUMAN_LEVEL);
+    gameRecord.timestamp = GameRecord::now();
+    gameRecord.result = result;
+    gameLog.append(gameRecord);
+    stats.recordGame(gameRecord.moveCount);
+}
+
+//Show the leaderboard one page at a time, best players first, and allow
+//user to find a player or reset it
 void Game::showLeaderboard() {
-    clearScreen();
-    cout << "================ LEADERBOARD ================\n";
+    if (!ranking.built()) {
+        ranking.build(leaderboard);
+    }
 
-    // Show leaderboard table
-    if (leaderboard.empty()) {
-        cout << "No games played yet.\n";
-    } else {
-        cout << left << setw(12) << "Player"
-             << right << setw(6) << "Wins"
-             << setw(8) << "Losses"
-             << setw(7) << "Draws"
-             << setw(10) << "WinRate" << "\n";
-        cout << "---------------------------------------------\n";
-
-        for (const auto& entry : leaderboard) {
-            const Player& p = entry.second;
-            int total = p.wins + p.losses + p.draws;
-            float rate = (total > 0) ? (p.wins * 100.0f / total) : 0;
-
-            cout << left << setw(12) << p.name
-                 << right << setw(6) << p.wins
-                 << setw(8) << p.losses
-                 << setw(7) << p.draws
-                 << setw(9) << fixed << setprecision(1) << rate << "%\n";
+    int first = 0;
+    string notice;
+    while (true) {
+        clearScreen();
+        cout << "=================== LEADERBOARD ===================\n";
+
+        // Show one page of the ranking
+        int total = ranking.size();
+        if (total == 0) {
+            cout << "No games played yet.\n";
+        } else {
+            cout << left << setw(6) << "Rank"
+                 << setw(12) << "Player"
+                 << right << setw(6) << "Wins"
+                 << setw(8) << "Losses"
+                 << setw(7) << "Draws"
+                 << setw(10) << "WinRate" << "\n";
+            cout << "---------------------------------------------------\n";
+
+            int rank = first;
+            for (int player : ranking.range(first, LEADERBOARD_PAGE_SIZE)) {
+                const PlayerRecord& p = leaderboard.at(player);
+                int games = p.wins + p.losses + p.draws;
+                float rate = (games > 0) ? (p.wins * 100.0f / games) : 0;
+
+                cout << left << setw(6) << ++rank
+                     << setw(12) << p.name
+                     << right << setw(6) << p.wins
+                     << setw(8) << p.losses
+                     << setw(7) << p.draws
+                     << setw(9) << fixed << setprecision(1) << rate << "%\n";
+            }
+            cout << "Showing " << first + 1 << "-" << rank << " of " << total << " players\n";
+        }
+        if (!notice.empty()) {
+            cout << notice << "\n";
+            notice.clear();
         }
-    }
 
-    cout << "=============================================\n";
-    cout << "Press 'r' to reset, or Enter to return: ";
+        cout << "===================================================\n";
+        cout << "n/p: next/previous page, f: find player,\n";
+        cout << "r: reset, or Enter to return: ";
 
-    // Read entire line input (so Enter = empty string, 'r' works too)
-    string input;
-    getline(cin, input);
+        // Read entire line input (so Enter = empty string, letters work too)
+        string input;
+        getline(cin, input);
+        if (input.empty()) {
+            return;
+        }
 
-    // If user pressed 'r' (case-insensitive), ask for confirmation
-    if (!input.empty() && tolower(input[0]) == 'r') {
-        cout << "Confirm reset? (y/n): ";
-        char confirm;
-        cin >> confirm;
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-        if (tolower(confirm) == 'y') {
-            resetLeaderboard();
-            cout << "Reset done!\n";
+        char choice = static_cast<char>(tolower(input[0]));
+        if (choice == 'n' && first + LEADERBOARD_PAGE_SIZE < total) {
+            first += LEADERBOARD_PAGE_SIZE;
+        } else if (choice == 'p') {
+            first = max(0, first - LEADERBOARD_PAGE_SIZE);
+        } else if (choice == 'f') {
+            cout << "Player name: ";
+            string name;
+            getline(cin, name);
+            int rank = ranking.rankOf(leaderboard.find(name));
+            if (rank < 0) {
+                notice = "No player named " + name + ".";
+            } else {
+                // Jump to the page that player is on
+                first = rank / LEADERBOARD_PAGE_SIZE * LEADERBOARD_PAGE_SIZE;
+                notice = name + " is ranked " + to_string(rank + 1) + " of " + to_string(total) + ".";
+            }
+        } else if (choice == 'r') {
+            // Ask for confirmation before resetting
+            cout << "Confirm reset? (y/n): ";
+            char confirm;
+            cin >> confirm;
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            if (tolower(confirm) == 'y') {
+                resetLeaderboard();
+                cout << "Reset done!\n";
+                return;
             }
+        }
     }
 }
 
@@ -576,11 +592,21 @@ void Game::showHelp() const {
     cout << "5. When all 9 squares are full, the game\n";
     cout << "   is over. If no player has 3 marks in a\n";
     cout << "   row, the game ends in a draw.\n";
+    cout << "6. Bigger boards are also available:\n";
+    cout << "   5x5 needs 4 in a row, 7x7 needs 5.\n";
+    cout << "7. The 4x4x4 cube has four layers; lines\n";
+    cout << "   of 4 also run between the layers and\n";
+    cout << "   through the middle, 76 in all.\n";
+    cout << "8. On 3x3, Medium plays from a table\n";
+    cout << "   learned by self-play when " << MEDIUM_POLICY_FILE << "\n";
+    cout << "   is present (run with --train to make it).\n";
     cout << "========================================\n";
     cout << "             GAME CONTROLS              \n";
     cout << "========================================\n";
-    cout << "Enter row and column numbers (1-3)\n";
-    cout << "when prompted. For example:\n";
+    cout << "Enter row and column numbers (1-3 on\n";
+    cout << "the classic board) when prompted, and\n";
+    cout << "first the layer on the cube.\n";
+    cout << "For example:\n";
     cout << "Row: 1, Column: 1 - Top-left corner\n";
     cout << "Row: 2, Column: 2 - Center position\n";
     cout << "Row: 3, Column: 3 - Bottom-right corner\n";
@@ -588,45 +614,41 @@ void Game::showHelp() const {
     waitForEnter();
 }
 
-// Save the leaderboard to a file
-void Game::saveLeaderboard() const {
-    ofstream file("leaderboard.txt");
-    if (file.is_open()) {
-        for (const auto& entry : leaderboard) {
-            const Player& player = entry.second;
-            file << player.name << "," << player.wins << "," << player.losses << "," << player.draws << "\n";
-        }
-        file.close();
-    }
+// Show what the AI and the leaderboard have cost this session
+void Game::showStats() const {
+    clearScreen();
+    cout << "========================================\n";
+    cout << "            SESSION STATISTICS          \n";
+    cout << "========================================\n";
+    cout << stats.summary();
+    cout << "========================================\n";
+    waitForEnter();
 }
 
-// Load the leaderboard from a file
+// Save the leaderboard: results are already in the mapped file, so this
+// only asks the OS to write them back
+void Game::saveLeaderboard() {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    leaderboard.flush();
+    chrono::nanoseconds spent = chrono::steady_clock::now() - start;
+    stats.recordLeaderboardSave(static_cast<uint64_t>(spent.count()));
+}
+
+// Map the leaderboard file; nothing is read until a player is looked up
 void Game::loadLeaderboard() {
-    ifstream file("leaderboard.txt");
-    if (file.is_open()) {
-        string line;
-        while (getline(file, line)) {
-            if (line.empty()) continue;
-            size_t p1 = line.find(',');
-            size_t p2 = line.find(',', p1 + 1);
-            size_t p3 = line.find(',', p2 + 1);
-
-            string name = line.substr(0, p1);
-            int wins = stoi(line.substr(p1 + 1, p2 - p1 - 1));
-            int losses = stoi(line.substr(p2 + 1, p3 - p2 - 1));
-            int draws = stoi(line.substr(p3 + 1));
-
-            leaderboard[name] = {name, wins, losses, draws};
-        }
-        file.close();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool opened = leaderboard.open();
+    chrono::nanoseconds spent = chrono::steady_clock::now() - start;
+    stats.recordLeaderboardLoad(static_cast<uint64_t>(spent.count()));
+    if (!opened) {
+        cout << "Warning: could not open " << leaderboard.path() << "; results will not be saved.\n";
     }
 }
 
-// Reset leaderboard by clearing memory and file
+// Reset leaderboard by clearing the file
 void Game::resetLeaderboard() {
-    leaderboard.clear(); // Clear in-memory data
-    ofstream file("leaderboard.txt", ios::trunc); // Truncate the file
-    file.close();
+    leaderboard.reset(); // Empty the file
+    ranking.clear();
     cout << "Leaderboard has been reset!\n";
     waitForEnter();
 }
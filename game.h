@@ -1,66 +1,101 @@
 #pragma once
 
 #include <string>
-#include <map>
+#include "tictactoe.h"
+#include "gamelog.h"
+#include "leaderboard_store.h"
+#include "ponder.h"
+#include "rank_index.h"
+#include "renderer.h"
+#include "stats.h"
+#include "trainer.h"
 
 // Constants
-const int BOARD_SIZE = 3;
+const int BOARD_SIZE = 3;              // classic board, solved by the perfect-play table
 const char EMPTY = ' ';
 const char PLAYER_X = 'X';
 const char PLAYER_O = 'O';
+const char LEADERBOARD_FILE[] = "leaderboard.dat";  // imports leaderboard.txt from older versions
+const int LEADERBOARD_PAGE_SIZE = 10;
+const int DEFAULT_AI_DELAY_MS = 1000;   // shortest time the AI's turn stays on screen
+const int DEFAULT_AI_DEADLINE_MS = 5000;    // longest time the AI may take for a move
 
-// Game difficulty levels
-enum class Difficulty { EASY, MEDIUM, HARD };
-
-// Player structure to track scores
-struct Player {
-    std::string name;
-    int wins;
-    int losses;
-    int draws;
+// Board variants offered at the start of a game
+struct BoardVariant {
+    int size;
+    int winLength;
+    int layers;                 // 1 for a flat board
 };
 
+const BoardVariant BOARD_VARIANTS[] = {{3, 3, 1}, {5, 4, 1}, {7, 5, 1}, {4, 4, 4}};
+const int BOARD_VARIANT_COUNT = 4;
+
+// Win length of the flat board variant of this size, or the size itself
+// if no variant has it
+int defaultWinLength(int size);
+
 class Game {
+    // The benchmark suite times the private hot paths directly
+    friend class GameBenchmark;
+    
 private:
-    char board[BOARD_SIZE][BOARD_SIZE];
+    GridPosition board;
+    const BoardGeometry* geometry;
     char currentPlayer;
     bool vsAI;
     Difficulty aiDifficulty;
-    std::map<std::string, Player> leaderboard;
+    unsigned long long searchNodes;
+    int searchDepth;
+    AISettings aiSettings;
+    int aiDelayMs;
+    int aiDeadlineMs;
+    unsigned long long searchPlayouts;
+    LeaderboardStore leaderboard;
+    RankIndex ranking;                  // built the first time the leaderboard is shown
     std::string player1Name;
     std::string player2Name;
+    GameLogWriter gameLog;              // every finished game, in the background
+    GameRecord gameRecord;              // moves of the game being played
+    GameStats stats;
+    std::string statsFile;              // JSON written here on exit, if set
+    PolicyTable mediumPolicy;           // learned 3x3 table for Medium, if one was found
+    Ponderer ponderer;                  // searches the AI's answers on the human's turn
     
     // Core game functions
     void initializeBoard();
-    bool isValidMove(int row, int col) const;
-    void makeMove(int row, int col);
+    void selectBoard(int size, int winLength, int layers = 1);
+    Position currentPosition(char toMove) const;
+    bool isValidMove(int row, int col, int layer = 0) const;
+    void makeMove(int row, int col, int layer = 0);
     bool checkWin(char player) const;
     bool checkDraw() const;
     void switchPlayer();
     
     // AI functions
     void makeAIMove();
-    std::pair<int, int> findBestMove();
-    int minimax(int depth, bool isMaximizing);
-    std::pair<int, int> findRandomMove() const;
-    std::pair<int, int> findWinningMove(char player) const;
-    std::pair<int, int> findBlockingMove() const;
+    MoveOptions aiMoveOptions() const;
+    bool aiPonders() const;
     
     // UI functions
+    mutable TerminalRenderer screen;    // remembers what is on the terminal
     void clearScreen() const;
-    void displayBoard() const;
-    void displayStatus() const;
+    void displayBoard(const std::string& status = "") const;
+    std::string statusLine() const;
     
     // Utility functions
+    void addToLeaderboard(const std::string& name);
     void updateLeaderboard(const std::string& name, bool won, bool draw = false);
-    void saveLeaderboard() const;
+    void saveLeaderboard();
+    void logGame(char result);
     void loadLeaderboard();
     std::string getPlayerName(const std::string& prompt);
     int getValidatedInput(const std::string& prompt, int min, int max);
     void waitForEnter() const;
     
 public:
-    Game();
+    explicit Game(const std::string& leaderboardFile = LEADERBOARD_FILE,
+                  const std::string& gameLogFile = GAME_LOG_FILE);
+    ~Game();
     
     // Main game flow
     void showMainMenu() const;
@@ -68,4 +103,34 @@ public:
     void showLeaderboard();
     void resetLeaderboard();
     void showHelp() const;
+    void showStats() const;
+    
+    // Number of minimax nodes visited by the last AI decision
+    unsigned long long lastSearchNodes() const;
+    
+    // Per-move thinking time for the AI on boards larger than 3x3
+    void setAITimeBudget(int milliseconds);
+    
+    // Threads the AI searches with on boards larger than 3x3
+    void setAIThreads(int threads);
+    
+    // Random games the Monte Carlo AI plays per move
+    void setAIPlayouts(int playouts);
+    
+    // Shortest pause on the AI's turn; time spent thinking counts toward it
+    void setAIDelay(int milliseconds);
+    
+    // Hard limit on the AI's thinking per move (0 for none); when it is
+    // reached the AI plays the best move it has found so far
+    void setAIDeadline(int milliseconds);
+    
+    // Write the session statistics as JSON to this file on exit
+    void setStatsFile(const std::string& path);
+    
+    // Have Medium play 3x3 from a table made by --train; false if the file
+    // cannot be read, in which case Medium keeps to its rules
+    bool setPolicyFile(const std::string& path);
+    
+    // How closely Medium follows the table, 0 to 100
+    void setPolicyStrength(int strength);
 };
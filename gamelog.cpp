@@ -0,0 +1,311 @@
+#include "gamelog.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[8] = {'T', 'T', 'T', 'G', 'A', 'M', 'E', 'S'};
+const size_t READ_BLOCK_SIZE = 4 << 20;
+const int LEVEL_COUNT = 4;              // Difficulty values stored in a record
+
+void put32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+uint32_t get32(const uint8_t* in) {
+    return in[0] | static_cast<uint32_t>(in[1]) << 8 | static_cast<uint32_t>(in[2]) << 16 |
+           static_cast<uint32_t>(in[3]) << 24;
+}
+
+// Bits needed to store an index below `count`
+int bitsFor(int count) {
+    return count <= 1 ? 0 : 32 - __builtin_clz(static_cast<unsigned>(count - 1));
+}
+
+GridMask allCells(int cellTotal) {
+    return cellTotal >= 64 ? ~GridMask(0) : (GridMask(1) << cellTotal) - 1;
+}
+
+// Bytes taken by the moves of a game on `cellTotal` cells
+size_t moveBytes(int cellTotal, int moveCount) {
+    int bits = 0;
+    for (int k = 0; k < moveCount; k++) {
+        bits += bitsFor(cellTotal - k);
+    }
+    return static_cast<size_t>(bits + 7) / 8;
+}
+
+}
+
+GameRecord::GameRecord()
+    : xPlayer(NO_PLAYER), oPlayer(NO_PLAYER), xLevel(HUMAN_LEVEL), oLevel(HUMAN_LEVEL), timestamp(0),
+      boardSize(3), winLength(3), layers(1), firstPlayer('X'), result(' '), openingMoves(0), moveCount(0) {
+}
+
+uint32_t GameRecord::now() {
+    return static_cast<uint32_t>(time(nullptr));
+}
+
+size_t encodeGameRecord(const GameRecord& record, uint8_t* out) {
+    int resultCode = record.result == 'X' ? 1 : record.result == 'O' ? 2 : record.result == 'D' ? 3 : 0;
+    put32(out, record.xPlayer);
+    put32(out + 4, record.oPlayer);
+    put32(out + 8, record.timestamp);
+    out[12] = static_cast<uint8_t>(record.boardSize << 4 | record.winLength);
+    out[13] = static_cast<uint8_t>((record.xLevel + 1) << 4 | (record.oLevel + 1));
+    out[14] = static_cast<uint8_t>(resultCode | (record.firstPlayer == 'O' ? 4 : 0) | (record.layers > 1 ? 8 : 0) |
+                                   min<int>(record.openingMoves, MAX_OPENING_MOVES) << 4);
+    out[15] = record.moveCount;
+
+    // Each move is its rank among the empty cells, so later moves need
+    // fewer bits
+    uint8_t* p = out + GAME_RECORD_HEADER_BYTES;
+    int cellTotal = record.layers * record.boardSize * record.boardSize;
+    GridMask empty = allCells(cellTotal);
+    uint64_t bits = 0;
+    int bitCount = 0;
+    for (int k = 0; k < record.moveCount; k++) {
+        GridMask cell = GridMask(1) << record.moves[k];
+        uint64_t index = static_cast<uint64_t>(__builtin_popcountll(empty & (cell - 1)));
+        bits |= index << bitCount;
+        bitCount += bitsFor(cellTotal - k);
+        empty &= ~cell;
+        while (bitCount >= 8) {
+            *p++ = static_cast<uint8_t>(bits);
+            bits >>= 8;
+            bitCount -= 8;
+        }
+    }
+    if (bitCount > 0) {
+        *p++ = static_cast<uint8_t>(bits);
+    }
+    return static_cast<size_t>(p - out);
+}
+
+int decodeGameRecord(const uint8_t* data, size_t available, GameRecord& record) {
+    if (available < GAME_RECORD_HEADER_BYTES) {
+        return 0;
+    }
+    int size = data[12] >> 4;
+    int winLength = data[12] & 15;
+    int xLevel = (data[13] >> 4) - 1;
+    int oLevel = (data[13] & 15) - 1;
+    int resultCode = data[14] & 3;
+    int moveCount = data[15];
+    int openingMoves = data[14] >> 4;
+    int layers = (data[14] & 8) ? size : 1;
+    int cellTotal = layers * size * size;
+    if (size < 3 || size > MAX_BOARD_SIZE || winLength < 3 || winLength > size || cellTotal > MAX_CELLS ||
+        xLevel >= LEVEL_COUNT || oLevel >= LEVEL_COUNT || moveCount > cellTotal || openingMoves > moveCount) {
+        return -1;
+    }
+    size_t bytes = GAME_RECORD_HEADER_BYTES + moveBytes(cellTotal, moveCount);
+    if (available < bytes) {
+        return 0;
+    }
+
+    record.xPlayer = get32(data);
+    record.oPlayer = get32(data + 4);
+    record.timestamp = get32(data + 8);
+    record.boardSize = static_cast<uint8_t>(size);
+    record.winLength = static_cast<uint8_t>(winLength);
+    record.layers = static_cast<uint8_t>(layers);
+    record.xLevel = static_cast<int8_t>(xLevel);
+    record.oLevel = static_cast<int8_t>(oLevel);
+    record.result = " XOD"[resultCode];
+    record.firstPlayer = (data[14] & 4) ? 'O' : 'X';
+    record.openingMoves = static_cast<uint8_t>(openingMoves);
+    record.moveCount = static_cast<uint8_t>(moveCount);
+
+    const uint8_t* p = data + GAME_RECORD_HEADER_BYTES;
+    GridMask empty = allCells(cellTotal);
+    uint64_t bits = 0;
+    int bitCount = 0;
+    for (int k = 0; k < moveCount; k++) {
+        int width = bitsFor(cellTotal - k);
+        while (bitCount < width) {
+            bits |= static_cast<uint64_t>(*p++) << bitCount;
+            bitCount += 8;
+        }
+        int index = static_cast<int>(bits & ((uint64_t(1) << width) - 1));
+        bits >>= width;
+        bitCount -= width;
+        if (index >= cellTotal - k) {
+            return -1;
+        }
+        GridMask remaining = empty;
+        for (int i = 0; i < index; i++) {
+            remaining &= remaining - 1;
+        }
+        int cell = __builtin_ctzll(remaining);
+        record.moves[k] = static_cast<uint8_t>(cell);
+        empty &= ~(GridMask(1) << cell);
+    }
+    return static_cast<int>(bytes);
+}
+
+GameLogWriter::GameLogWriter(const string& path) : filePath(path), file(nullptr), stopping(false) {
+}
+
+GameLogWriter::~GameLogWriter() {
+    close();
+}
+
+bool GameLogWriter::open() {
+    if (file) {
+        return true;
+    }
+
+    // Never append to something that is not a game log
+    bool fresh = true;
+    FILE* existing = fopen(filePath.c_str(), "rb");
+    if (existing) {
+        uint8_t header[GAME_LOG_HEADER_BYTES];
+        size_t got = fread(header, 1, sizeof(header), existing);
+        fclose(existing);
+        if (got > 0 && (got < sizeof(header) || memcmp(header, MAGIC, sizeof(MAGIC)) != 0 ||
+                        get32(header + 8) != GAME_LOG_VERSION)) {
+            return false;
+        }
+        fresh = got == 0;
+    }
+
+    file = fopen(filePath.c_str(), "ab");
+    if (!file) {
+        return false;
+    }
+    if (fresh) {
+        uint8_t header[GAME_LOG_HEADER_BYTES] = {};
+        memcpy(header, MAGIC, sizeof(MAGIC));
+        put32(header + 8, GAME_LOG_VERSION);
+        fwrite(header, 1, sizeof(header), file);
+        fflush(file);
+    }
+    stopping = false;
+    writer = thread(&GameLogWriter::writerLoop, this);
+    return true;
+}
+
+void GameLogWriter::append(const GameRecord& record) {
+    if (!file) {
+        return;
+    }
+    uint8_t bytes[MAX_GAME_RECORD_BYTES];
+    size_t length = encodeGameRecord(record, bytes);
+
+    bool wasEmpty;
+    {
+        lock_guard<mutex> guard(lock);
+        wasEmpty = pending.empty();
+        pending.insert(pending.end(), bytes, bytes + length);
+    }
+    // The writer only sleeps when there is nothing queued
+    if (wasEmpty) {
+        wake.notify_one();
+    }
+}
+
+void GameLogWriter::close() {
+    if (!file) {
+        return;
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+    fclose(file);
+    file = nullptr;
+}
+
+// Take whatever has been queued and write it outside the lock
+void GameLogWriter::writerLoop() {
+    vector<uint8_t> batch;
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [this] { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            break;
+        }
+        batch.swap(pending);
+        guard.unlock();
+        fwrite(batch.data(), 1, batch.size(), file);
+        fflush(file);
+        batch.clear();
+        guard.lock();
+    }
+}
+
+GameLogReader::GameLogReader(const string& path)
+    : filePath(path), file(nullptr), start(0), end(0), consumed(0), isDamaged(false) {
+}
+
+GameLogReader::~GameLogReader() {
+    if (file) {
+        fclose(file);
+    }
+}
+
+bool GameLogReader::open() {
+    file = fopen(filePath.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    uint8_t header[GAME_LOG_HEADER_BYTES];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || get32(header + 8) != GAME_LOG_VERSION) {
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+    buffer.resize(READ_BLOCK_SIZE);
+    start = 0;
+    end = 0;
+    consumed = sizeof(header);
+    return true;
+}
+
+bool GameLogReader::read(vector<GameRecord>& records, size_t limit) {
+    records.clear();
+    while (records.size() < limit) {
+        // Top the buffer up whenever a whole record might not be in it
+        if (file && end - start < MAX_GAME_RECORD_BYTES) {
+            memmove(buffer.data(), buffer.data() + start, end - start);
+            end -= start;
+            start = 0;
+            size_t got = fread(buffer.data() + end, 1, buffer.size() - end, file);
+            end += got;
+            if (got == 0) {
+                fclose(file);
+                file = nullptr;
+            }
+        }
+        if (start == end) {
+            break;
+        }
+
+        GameRecord record;
+        int used = decodeGameRecord(buffer.data() + start, end - start, record);
+        if (used <= 0) {
+            // A cut-off record at the end of the file, or garbage
+            isDamaged = true;
+            start = end;
+            if (file) {
+                fclose(file);
+                file = nullptr;
+            }
+            break;
+        }
+        records.push_back(record);
+        start += used;
+        consumed += used;
+    }
+    return !records.empty();
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "engine.h"
+
+const char GAME_LOG_FILE[] = "games.log";
+const uint32_t NO_PLAYER = 0xFFFFFFFF;  // the AI, or someone not on the leaderboard
+const int HUMAN_LEVEL = -1;             // a side played by a person
+const int MAX_OPENING_MOVES = 15;       // random opening plies a record can mark
+
+// One finished (or abandoned) game
+struct GameRecord {
+    uint32_t xPlayer;           // leaderboard record number, or NO_PLAYER
+    uint32_t oPlayer;
+    int8_t xLevel;              // Difficulty of an AI side, or HUMAN_LEVEL
+    int8_t oLevel;
+    uint32_t timestamp;         // seconds since 1970
+    uint8_t boardSize;
+    uint8_t winLength;
+    uint8_t layers;             // 1, or boardSize for a cube
+    char firstPlayer;           // 'X' or 'O'
+    char result;                // 'X', 'O', 'D' for a draw, ' ' if unfinished
+    uint8_t openingMoves;       // first moves drawn at random, played by neither side's AI
+    uint8_t moveCount;
+    uint8_t moves[MAX_CELLS];   // cells in the order played
+
+    GameRecord();
+    // Seconds since 1970, for the timestamp
+    static uint32_t now();
+};
+
+// Binary game log (little-endian, version 1):
+//   file header  "TTTGAMES", uint32 version, uint32 reserved
+//   records      back to back, each a 16-byte header followed by the moves
+// Record header: X and O player (uint32 each), timestamp (uint32), board
+// size << 4 | win length, X level + 1 << 4 | O level + 1 (0 for a person),
+// result (0 unfinished, 1 X, 2 O, 3 draw) | 4 if O moved first | 8 if
+// the board is a cube of `size` layers | opening moves << 4, and the move
+// count. Each move is stored as its index among the cells still empty,
+// in just enough bits for that count, packed from the low bit up: a whole
+// 3x3 game fits in 3 bytes.
+const uint32_t GAME_LOG_VERSION = 1;
+const size_t GAME_LOG_HEADER_BYTES = 16;
+const size_t GAME_RECORD_HEADER_BYTES = 16;
+const size_t MAX_GAME_RECORD_BYTES = GAME_RECORD_HEADER_BYTES + (MAX_CELLS * 6 + 7) / 8;
+
+// Encode a record; returns the bytes written, at most MAX_GAME_RECORD_BYTES
+size_t encodeGameRecord(const GameRecord& record, uint8_t* out);
+// Decode one record from `available` bytes: the bytes used, 0 if the
+// record is cut short, or -1 if the data is not a valid record
+int decodeGameRecord(const uint8_t* data, size_t available, GameRecord& record);
+
+// Appends records to a log on its own thread. append() only encodes into
+// a memory buffer under a short lock, so a slow disk never holds up a
+// game; the thread swaps the buffer out and writes it in one call.
+class GameLogWriter {
+public:
+    explicit GameLogWriter(const std::string& path);
+    ~GameLogWriter();
+
+    // Open the log for appending, writing the file header if it is new;
+    // false if it cannot be opened or is not a game log
+    bool open();
+    bool isOpen() const { return file != nullptr; }
+    // Queue one record; does nothing if the log is not open
+    void append(const GameRecord& record);
+    // Write everything queued and stop the writer thread
+    void close();
+
+    const std::string& path() const { return filePath; }
+
+private:
+    std::string filePath;
+    FILE* file;
+    std::thread writer;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::vector<uint8_t> pending;
+    bool stopping;
+
+    void writerLoop();
+};
+
+// Reads a log front to back in large blocks
+class GameLogReader {
+public:
+    explicit GameLogReader(const std::string& path);
+    ~GameLogReader();
+
+    // False if the file cannot be read or is not a game log
+    bool open();
+    // Decode up to `limit` more records into `records`, replacing what was
+    // there; false at the end of the log
+    bool read(std::vector<GameRecord>& records, size_t limit);
+    // Bytes consumed so far, file header included
+    unsigned long long bytesRead() const { return consumed; }
+    // True if the log ended in a partial record or bytes that are not one
+    bool damaged() const { return isDamaged; }
+
+private:
+    std::string filePath;
+    FILE* file;
+    std::vector<uint8_t> buffer;
+    size_t start;
+    size_t end;
+    unsigned long long consumed;
+    bool isDamaged;
+};
@@ -0,0 +1,64 @@
+#include "latency.h"
+
+LatencyHistogram::LatencyHistogram() : buckets(), total(0), sum(0), largest(0) {
+}
+
+// Values below 8 get a bucket each; above that the top 3 bits after the
+// leading one pick one of 8 buckets within the power of two
+int LatencyHistogram::bucketOf(uint64_t nanoseconds) {
+    if (nanoseconds < 8) {
+        return static_cast<int>(nanoseconds);
+    }
+    int exponent = 63 - __builtin_clzll(nanoseconds);
+    int sub = static_cast<int>(nanoseconds >> (exponent - 3)) & 7;
+    int bucket = (exponent - 2) * 8 + sub;
+    return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+}
+
+// Largest value that falls in the bucket
+uint64_t LatencyHistogram::bucketLimit(int bucket) {
+    if (bucket < 8) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int exponent = bucket / 8 + 2;
+    uint64_t sub = static_cast<uint64_t>(bucket % 8);
+    return ((8 + sub + 1) << (exponent - 3)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    buckets[bucketOf(nanoseconds)]++;
+    total++;
+    sum += nanoseconds;
+    if (nanoseconds > largest) largest = nanoseconds;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    if (other.largest > largest) largest = other.largest;
+}
+
+double LatencyHistogram::mean() const {
+    return total == 0 ? 0.0 : static_cast<double>(sum) / total;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(fraction * total);
+    if (rank >= total) rank = total - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen > rank) {
+            uint64_t limit = bucketLimit(i);
+            return limit < largest ? limit : largest;
+        }
+    }
+    return largest;
+}
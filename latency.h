@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// Log-linear histogram of durations in nanoseconds: 8 buckets per power of
+// two, so any percentile it reports is within 12.5% of the true value.
+// Recording is a few instructions and never allocates.
+class LatencyHistogram {
+public:
+    static const int BUCKET_COUNT = 8 * 62;
+
+    LatencyHistogram();
+
+    void record(uint64_t nanoseconds);
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return largest; }
+    double mean() const;
+    // Upper edge of the bucket holding the given fraction (0..1) of samples
+    uint64_t percentile(double fraction) const;
+
+private:
+    uint64_t buckets[BUCKET_COUNT];
+    uint64_t total;
+    uint64_t sum;
+    uint64_t largest;
+
+    static int bucketOf(uint64_t nanoseconds);
+    static uint64_t bucketLimit(int bucket);
+};
@@ -0,0 +1,517 @@
+#include "leaderboard_store.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct LeaderboardStore::FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t slotCount;
+    uint32_t indexDirty;    // non-zero while the index is being changed
+};
+
+namespace {
+
+const char FILE_MAGIC[8] = {'T', 'T', 'T', 'B', 'O', 'A', 'R', 'D'};
+const uint32_t INITIAL_CAPACITY = 1024;
+const uint32_t MAX_CAPACITY = 1u << 26;
+
+const char SNAPSHOT_HEADER[] = "# TicTacToe leaderboard v";
+const char JOURNAL_HEADER[] = "# TicTacToe journal ";
+
+// FNV-1a
+uint32_t hashName(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (; *name; name++) {
+        hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+    }
+    return hash;
+}
+
+bool fileExists(const string& path) {
+    ifstream file(path);
+    return file.good();
+}
+
+// Atomically put `from` in place of `to`
+bool replaceFile(const string& from, const string& to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// "leaderboard.dat" -> "leaderboard.txt"; empty if the path is a .txt itself
+string legacyTextPath(const string& path) {
+    size_t slash = path.find_last_of("/\\");
+    size_t dot = path.rfind('.');
+    string stem = (dot == string::npos || (slash != string::npos && dot < slash)) ? path : path.substr(0, dot);
+    string text = stem + ".txt";
+    return text == path ? "" : text;
+}
+
+bool startsWith(const string& text, const char* prefix) {
+    return text.compare(0, char_traits<char>::length(prefix), prefix) == 0;
+}
+
+// Strip the carriage return of files written on Windows
+void trimLineEnd(string& line) {
+    if (!line.empty() && line[line.size() - 1] == '\r') {
+        line.erase(line.size() - 1);
+    }
+}
+
+bool parseCount(const string& text, int& value) {
+    if (text.empty()) return false;
+    char* end;
+    long parsed = strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || parsed < 0) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// "name,wins,losses,draws" (v1 and v2) or "name wins losses draws" (v0,
+// where the name itself may contain spaces); false for anything else
+bool parsePlayer(const string& line, Player& player) {
+    string fields[4];
+    if (line.find(',') != string::npos) {
+        size_t start = 0;
+        for (int i = 0; i < 4; i++) {
+            size_t comma = i < 3 ? line.find(',', start) : string::npos;
+            if (i < 3 && comma == string::npos) return false;
+            fields[i] = line.substr(start, comma == string::npos ? string::npos : comma - start);
+            start = comma + 1;
+        }
+    } else {
+        size_t end = line.find_last_not_of(' ');
+        for (int i = 3; i >= 1; i--) {
+            if (end == string::npos) return false;
+            size_t space = line.find_last_of(' ', end);
+            if (space == string::npos) return false;
+            fields[i] = line.substr(space + 1, end - space);
+            end = line.find_last_not_of(' ', space);
+        }
+        if (end == string::npos) return false;
+        fields[0] = line.substr(0, end + 1);
+    }
+
+    player.name = fields[0];
+    return !player.name.empty() && parseCount(fields[1], player.wins) &&
+           parseCount(fields[2], player.losses) && parseCount(fields[3], player.draws);
+}
+
+// Text leaderboard of versions 0 to 2; returns the version, or -1 if
+// there is no such file
+int readTextSnapshot(const string& path, map<string, Player>& players, uint64_t& absorbed) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        return -1;
+    }
+
+    int version = -1;
+    string line;
+    while (getline(file, line)) {
+        trimLineEnd(line);
+        if (line.empty()) continue;
+        if (version < 0 && startsWith(line, SNAPSHOT_HEADER)) {
+            version = atoi(line.c_str() + char_traits<char>::length(SNAPSHOT_HEADER));
+            size_t mark = line.find("journal ");
+            if (mark != string::npos) absorbed = strtoull(line.c_str() + mark + 8, nullptr, 10);
+            continue;
+        }
+        if (version < 0) {
+            version = line.find(',') != string::npos ? 1 : 0;
+        }
+
+        Player player;
+        if (parsePlayer(line, player)) {
+            players[player.name] = player;
+        }
+    }
+    return version < 0 ? 2 : version;
+}
+
+// Results a version 2 leaderboard journaled after its last snapshot.
+// A last line cut short by a crash is ignored.
+void replayTextJournal(const string& path, uint64_t absorbed, map<string, Player>& players) {
+    ifstream in(path);
+    string line;
+    if (!in.is_open() || !getline(in, line) || !startsWith(line, JOURNAL_HEADER)) {
+        return;
+    }
+    if (strtoull(line.c_str() + char_traits<char>::length(JOURNAL_HEADER), nullptr, 10) <= absorbed) {
+        return;
+    }
+
+    while (getline(in, line)) {
+        if (in.eof()) break; // No newline: the write never finished
+        trimLineEnd(line);
+        if (line.size() < 3 || line[1] != '\t') continue;
+
+        string name = line.substr(2);
+        Player& player = players[name];
+        player.name = name;
+        switch (line[0]) {
+            case 'W': player.wins++; break;
+            case 'L': player.losses++; break;
+            case 'D': player.draws++; break;
+        }
+    }
+}
+
+}
+
+LeaderboardStore::LeaderboardStore(const string& path)
+    : filePath(path), base(nullptr), mappedBytes(0),
+#ifdef _WIN32
+      fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+#else
+      fileDescriptor(-1)
+#endif
+{
+}
+
+LeaderboardStore::~LeaderboardStore() {
+    close();
+}
+
+bool LeaderboardStore::open() {
+    close();
+
+    // Build a new file under a temporary name, so a crash part-way through
+    // an import leaves the text leaderboard to import again next time
+    if (!fileExists(filePath)) {
+        string temporary = filePath + ".tmp";
+        if (!mapFile(temporary, true)) {
+            close();
+            return false;
+        }
+        string textPath = legacyTextPath(filePath);
+        int version = textPath.empty() ? -1 : importText(textPath);
+        close();
+        if (!replaceFile(temporary, filePath)) {
+            return false;
+        }
+        if (version >= 0) {
+            replaceFile(textPath, textPath + ".v" + to_string(version) + ".bak");
+            remove((textPath + ".journal").c_str());
+            remove((textPath + ".journal.old").c_str());
+        }
+    }
+
+    if (!mapFile(filePath, false) || !valid()) {
+        close();
+        return false;
+    }
+    if (header()->indexDirty) {
+        rebuildIndex();
+    }
+    return true;
+}
+
+void LeaderboardStore::close() {
+    if (base) {
+        flush();
+    }
+    unmap();
+}
+
+int LeaderboardStore::size() const {
+    return base ? static_cast<int>(header()->count) : 0;
+}
+
+int LeaderboardStore::find(const string& name) const {
+    if (!base || name.size() > static_cast<size_t>(MAX_NAME_LENGTH)) {
+        return -1;
+    }
+    uint32_t slot = *findSlot(name.c_str(), hashName(name.c_str()));
+    return slot == 0 ? -1 : static_cast<int>(slot - 1);
+}
+
+int LeaderboardStore::addPlayer(const string& name) {
+    if (!base || name.empty() || name.size() > static_cast<size_t>(MAX_NAME_LENGTH)) {
+        return -1;
+    }
+    int index = find(name);
+    if (index >= 0) {
+        return index;
+    }
+    if (header()->count == header()->capacity && !grow()) {
+        return -1;
+    }
+
+    FileHeader* file = header();
+    uint32_t count = file->count;
+    PlayerRecord& player = records()[count];
+    memset(&player, 0, sizeof(player));
+    memcpy(player.name, name.c_str(), name.size());
+    player.nameHash = hashName(player.name);
+
+    file->indexDirty = 1;
+    *findSlot(player.name, player.nameHash) = count + 1;
+    file->count = count + 1;
+    file->indexDirty = 0;
+    return static_cast<int>(count);
+}
+
+bool LeaderboardStore::setPlayer(const Player& player) {
+    int index = addPlayer(player.name);
+    if (index < 0) {
+        return false;
+    }
+    PlayerRecord& record = records()[index];
+    record.wins = player.wins;
+    record.losses = player.losses;
+    record.draws = player.draws;
+    return true;
+}
+
+bool LeaderboardStore::record(const string& name, GameOutcome outcome) {
+    return record(find(name), outcome);
+}
+
+bool LeaderboardStore::record(int index, GameOutcome outcome) {
+    if (index < 0 || index >= size()) {
+        return false;
+    }
+    PlayerRecord& player = records()[index];
+    switch (outcome) {
+        case GameOutcome::WIN: player.wins++; break;
+        case GameOutcome::LOSS: player.losses++; break;
+        case GameOutcome::DRAW: player.draws++; break;
+    }
+    return true;
+}
+
+bool LeaderboardStore::addResults(int index, int wins, int losses, int draws) {
+    if (index < 0 || index >= size()) {
+        return false;
+    }
+    PlayerRecord& player = records()[index];
+    player.wins += wins;
+    player.losses += losses;
+    player.draws += draws;
+    return true;
+}
+
+void LeaderboardStore::reset() {
+    if (!base) {
+        return;
+    }
+    FileHeader* file = header();
+    file->indexDirty = 1;
+    file->count = 0;
+    memset(slots(), 0, size_t(file->slotCount) * sizeof(uint32_t));
+    file->indexDirty = 0;
+}
+
+void LeaderboardStore::flush() {
+    if (!base) {
+        return;
+    }
+#ifdef _WIN32
+    FlushViewOfFile(base, 0);
+#else
+    msync(base, mappedBytes, MS_ASYNC);
+#endif
+}
+
+// Header, records, then two index slots per record
+size_t LeaderboardStore::fileBytes(uint32_t capacity) {
+    return sizeof(FileHeader) + size_t(capacity) * (sizeof(PlayerRecord) + 2 * sizeof(uint32_t));
+}
+
+LeaderboardStore::FileHeader* LeaderboardStore::header() const {
+    return reinterpret_cast<FileHeader*>(base);
+}
+
+PlayerRecord* LeaderboardStore::records() const {
+    return reinterpret_cast<PlayerRecord*>(base + sizeof(FileHeader));
+}
+
+uint32_t* LeaderboardStore::slots() const {
+    return reinterpret_cast<uint32_t*>(base + sizeof(FileHeader) + size_t(header()->capacity) * sizeof(PlayerRecord));
+}
+
+// Open and map a file; `create` starts it over as an empty leaderboard
+bool LeaderboardStore::mapFile(const string& file, bool create) {
+    size_t existing = 0;
+#ifdef _WIN32
+    fileHandle = CreateFileA(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                             create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize;
+    if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize)) {
+        return false;
+    }
+    existing = static_cast<size_t>(fileSize.QuadPart);
+#else
+    fileDescriptor = ::open(file.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+    struct stat info;
+    if (fileDescriptor < 0 || fstat(fileDescriptor, &info) != 0) {
+        return false;
+    }
+    existing = static_cast<size_t>(info.st_size);
+#endif
+
+    if (existing == 0) {
+        if (!resizeAndMap(fileBytes(INITIAL_CAPACITY))) {
+            return false;
+        }
+        initialize(INITIAL_CAPACITY);
+        return true;
+    }
+    return existing >= sizeof(FileHeader) && resizeAndMap(existing);
+}
+
+// (Re)map the open file at `bytes` long, extending it if it is shorter
+bool LeaderboardStore::resizeAndMap(size_t bytes) {
+#ifdef _WIN32
+    if (base) {
+        UnmapViewOfFile(base);
+        CloseHandle(mappingHandle);
+        base = nullptr;
+    }
+    // A mapping larger than the file extends the file
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE, static_cast<DWORD>(uint64_t(bytes) >> 32),
+                                       static_cast<DWORD>(bytes), nullptr);
+    if (!mappingHandle) {
+        return false;
+    }
+    base = static_cast<char*>(MapViewOfFile(mappingHandle, FILE_MAP_WRITE, 0, 0, bytes));
+#else
+    if (base) {
+        munmap(base, mappedBytes);
+        base = nullptr;
+    }
+    struct stat info;
+    if (fstat(fileDescriptor, &info) != 0 ||
+        (static_cast<size_t>(info.st_size) < bytes && ftruncate(fileDescriptor, static_cast<off_t>(bytes)) != 0)) {
+        return false;
+    }
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    base = memory == MAP_FAILED ? nullptr : static_cast<char*>(memory);
+#endif
+    mappedBytes = base ? bytes : 0;
+    return base != nullptr;
+}
+
+void LeaderboardStore::unmap() {
+#ifdef _WIN32
+    if (base) UnmapViewOfFile(base);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (base) munmap(base, mappedBytes);
+    if (fileDescriptor >= 0) ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+    base = nullptr;
+    mappedBytes = 0;
+}
+
+// Header of an empty leaderboard; the new file is all zeros otherwise
+void LeaderboardStore::initialize(uint32_t capacity) {
+    FileHeader* file = header();
+    memcpy(file->magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    file->version = FORMAT_VERSION;
+    file->recordSize = sizeof(PlayerRecord);
+    file->count = 0;
+    file->capacity = capacity;
+    file->slotCount = capacity * 2;
+    file->indexDirty = 0;
+}
+
+// Refuse files from another version or machine, and truncated files
+bool LeaderboardStore::valid() const {
+    const FileHeader* file = header();
+    return memcmp(file->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 && file->version == FORMAT_VERSION &&
+           file->recordSize == sizeof(PlayerRecord) && file->capacity > 0 && file->capacity <= MAX_CAPACITY &&
+           (file->capacity & (file->capacity - 1)) == 0 && file->slotCount == file->capacity * 2 &&
+           file->count <= file->capacity && mappedBytes >= fileBytes(file->capacity);
+}
+
+// Double the record capacity. The records stay where they are; the index
+// moves to the new end of the file and is rebuilt.
+bool LeaderboardStore::grow() {
+    uint32_t capacity = header()->capacity * 2;
+    if (capacity > MAX_CAPACITY || !resizeAndMap(fileBytes(capacity))) {
+        return false;
+    }
+    FileHeader* file = header();
+    file->indexDirty = 1;
+    file->capacity = capacity;
+    file->slotCount = capacity * 2;
+    rebuildIndex();
+    return true;
+}
+
+void LeaderboardStore::rebuildIndex() {
+    FileHeader* file = header();
+    file->indexDirty = 1;
+    memset(slots(), 0, size_t(file->slotCount) * sizeof(uint32_t));
+    PlayerRecord* players = records();
+    for (uint32_t i = 0; i < file->count; i++) {
+        players[i].name[MAX_NAME_LENGTH] = '\0';
+        players[i].nameHash = hashName(players[i].name);
+        *findSlot(players[i].name, players[i].nameHash) = i + 1;
+    }
+    file->indexDirty = 0;
+}
+
+// The slot holding `name`, or the empty slot where it would go. Linear
+// probing; the index is never more than half full, so this terminates.
+uint32_t* LeaderboardStore::findSlot(const char* name, uint32_t hash) const {
+    uint32_t* table = slots();
+    const PlayerRecord* players = records();
+    uint32_t mask = header()->slotCount - 1;
+    for (uint32_t position = hash & mask;; position = (position + 1) & mask) {
+        uint32_t slot = table[position];
+        if (slot == 0) {
+            return &table[position];
+        }
+        const PlayerRecord& player = players[slot - 1];
+        if (player.nameHash == hash && strcmp(player.name, name) == 0) {
+            return &table[position];
+        }
+    }
+}
+
+// Copy a text leaderboard, and any results it journaled, into the mapped
+// file; returns its version, or -1 if there is none
+int LeaderboardStore::importText(const string& textPath) {
+    map<string, Player> players;
+    uint64_t absorbed = 0;
+    int version = readTextSnapshot(textPath, players, absorbed);
+    if (version < 0) {
+        return -1;
+    }
+    replayTextJournal(textPath + ".journal.old", absorbed, players);
+    replayTextJournal(textPath + ".journal", absorbed, players);
+
+    for (auto& entry : players) {
+        Player& player = entry.second;
+        if (player.name.size() > static_cast<size_t>(MAX_NAME_LENGTH)) {
+            player.name.resize(MAX_NAME_LENGTH);
+        }
+        setPlayer(player);
+    }
+    return version;
+}
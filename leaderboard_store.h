@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+const int MAX_NAME_LENGTH = 31;
+
+// Player structure to track scores
+struct Player {
+    std::string name;
+    int wins;
+    int losses;
+    int draws;
+};
+
+// One player as laid out in the leaderboard file
+struct PlayerRecord {
+    char name[MAX_NAME_LENGTH + 1];     // NUL-terminated
+    int32_t wins;
+    int32_t losses;
+    int32_t draws;
+    uint32_t nameHash;
+};
+
+enum class GameOutcome : char { WIN = 'W', LOSS = 'L', DRAW = 'D' };
+
+// Keeps the leaderboard in a binary file that is mapped into memory, so
+// opening it costs the same however many players it holds and recording a
+// result writes one counter of one record in place.
+//
+// File layout (native byte order, version 3):
+//   header    magic, version, record count and capacity, index size
+//   records   `capacity` fixed-size PlayerRecords, in the order added
+//   index     open-addressing hash table of record numbers by name,
+//             at least twice as many slots as records
+// When the records run out the file is doubled and the index rebuilt.
+// The header carries a flag that is set while the index is being changed,
+// so an index left half-written by a crash is rebuilt on the next open.
+//
+// A text leaderboard from an older version next to the file (same name
+// with a .txt extension: v0 "name wins losses draws", v1 "name,wins,
+// losses,draws", or v2 with a header and a results journal) is imported
+// the first time, then kept as <name>.txt.v<N>.bak.
+class LeaderboardStore {
+public:
+    static const uint32_t FORMAT_VERSION = 3;
+
+    explicit LeaderboardStore(const std::string& path);
+    ~LeaderboardStore();
+
+    // Map the file, creating or importing it first if needed; false if it
+    // cannot be used, in which case the store stays empty
+    bool open();
+    void close();
+
+    int size() const;
+    const PlayerRecord& at(int index) const { return records()[index]; }
+    // Record number of the player, or -1
+    int find(const std::string& name) const;
+    // Find the player, adding a record with no games if needed; -1 if the
+    // file cannot grow
+    int addPlayer(const std::string& name);
+    // Overwrite a player's counters, adding the player if needed
+    bool setPlayer(const Player& player);
+    // Count one game for an existing player; false if there is no such player
+    bool record(const std::string& name, GameOutcome outcome);
+    bool record(int index, GameOutcome outcome);
+    // Add several games at once to an existing player's counters
+    bool addResults(int index, int wins, int losses, int draws);
+    // Forget every player
+    void reset();
+    // Start writing changed pages back to the file
+    void flush();
+
+    const std::string& path() const { return filePath; }
+
+private:
+    struct FileHeader;
+
+    std::string filePath;
+    char* base;
+    size_t mappedBytes;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+
+    static size_t fileBytes(uint32_t capacity);
+    FileHeader* header() const;
+    PlayerRecord* records() const;
+    uint32_t* slots() const;
+
+    bool mapFile(const std::string& file, bool create);
+    bool resizeAndMap(size_t bytes);
+    void unmap();
+    void initialize(uint32_t capacity);
+    bool valid() const;
+    bool grow();
+    void rebuildIndex();
+    uint32_t* findSlot(const char* name, uint32_t hash) const;
+    int importText(const std::string& textPath);
+};
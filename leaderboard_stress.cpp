@@ -0,0 +1,157 @@
+#include "leaderboard_stress.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "concurrent_leaderboard.h"
+
+using namespace std;
+
+namespace {
+
+const GameOutcome OUTCOMES[3] = {GameOutcome::WIN, GameOutcome::LOSS, GameOutcome::DRAW};
+
+// splitmix64, so each thread's sequence of players is fixed
+uint64_t mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+void printUsage() {
+    cout << "Usage: TicTacToe_Project --stress-leaderboard [options]\n"
+         << "  --threads N       threads reporting results (default 8)\n"
+         << "  --players N       distinct player names (default 10000)\n"
+         << "  --updates N       results per thread (default 500000)\n"
+         << "  --stripes N       lock stripes; 1 for a single lock (default "
+         << ConcurrentLeaderboard::DEFAULT_STRIPES << ")\n"
+         << "  --leaderboard PATH scratch file (default stress_leaderboard.dat)\n";
+}
+
+}
+
+StressOptions::StressOptions()
+    : threads(8), players(10000), updates(500000), stripes(ConcurrentLeaderboard::DEFAULT_STRIPES),
+      leaderboardFile("stress_leaderboard.dat") {
+}
+
+bool runLeaderboardStress(const StressOptions& options, StressReport& report) {
+    LeaderboardStore store(options.leaderboardFile);
+    if (!store.open()) {
+        return false;
+    }
+    store.reset();
+
+    vector<string> names(options.players);
+    char name[24];
+    for (int i = 0; i < options.players; i++) {
+        snprintf(name, sizeof(name), "player%07d", i);
+        names[i] = name;
+    }
+    // Per thread and player: wins, losses, draws
+    vector<vector<int> > reference(options.threads, vector<int>(3 * options.players, 0));
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    {
+        ConcurrentLeaderboard leaderboard(store, options.stripes);
+        vector<thread> threads;
+        for (int t = 0; t < options.threads; t++) {
+            threads.push_back(thread([&, t] {
+                vector<int>& counts = reference[t];
+                uint64_t random = static_cast<uint64_t>(t) + 1;
+                for (long long i = 0; i < options.updates; i++) {
+                    random = mix(random);
+                    int player = static_cast<int>(random % static_cast<uint64_t>(options.players));
+                    int outcome = static_cast<int>((random >> 32) % 3);
+                    leaderboard.record(names[player], OUTCOMES[outcome]);
+                    counts[3 * player + outcome]++;
+                }
+            }));
+        }
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+        leaderboard.flush();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    report = StressReport();
+    report.updates = static_cast<long long>(options.threads) * options.updates;
+    report.seconds = elapsed.count();
+    for (int i = 0; i < options.players; i++) {
+        long long expected[3] = {0, 0, 0};
+        for (int t = 0; t < options.threads; t++) {
+            for (int k = 0; k < 3; k++) expected[k] += reference[t][3 * i + k];
+        }
+        report.expected += expected[0] + expected[1] + expected[2];
+
+        int player = store.find(names[i]);
+        long long stored[3] = {0, 0, 0};
+        if (player >= 0) {
+            const PlayerRecord& record = store.at(player);
+            stored[0] = record.wins;
+            stored[1] = record.losses;
+            stored[2] = record.draws;
+        }
+        report.stored += stored[0] + stored[1] + stored[2];
+        if (stored[0] != expected[0] || stored[1] != expected[1] || stored[2] != expected[2]) {
+            report.wrongPlayers++;
+        }
+    }
+    return true;
+}
+
+int stressMain(int argc, char* argv[]) {
+    StressOptions options;
+    for (int i = 0; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--help") {
+            printUsage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            cout << "Missing value for " << flag << "\n";
+            printUsage();
+            return 1;
+        }
+        string value = argv[++i];
+        if (flag == "--threads") options.threads = atoi(value.c_str());
+        else if (flag == "--players") options.players = atoi(value.c_str());
+        else if (flag == "--updates") options.updates = atoll(value.c_str());
+        else if (flag == "--stripes") options.stripes = atoi(value.c_str());
+        else if (flag == "--leaderboard") options.leaderboardFile = value;
+        else {
+            cout << "Invalid option: " << flag << " " << value << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (options.threads < 1 || options.players < 1 || options.updates < 0 || options.stripes < 1) {
+        cout << "Threads, players and stripes must be positive\n";
+        return 1;
+    }
+
+    cout << "Stress: " << options.threads << " threads x " << options.updates << " results over "
+         << options.players << " players, " << options.stripes << " stripes\n";
+    StressReport report;
+    bool ran = runLeaderboardStress(options, report);
+    remove(options.leaderboardFile.c_str());
+    if (!ran) {
+        cout << "Could not open " << options.leaderboardFile << "\n";
+        return 1;
+    }
+
+    double seconds = report.seconds > 0 ? report.seconds : 1e-9;
+    cout << fixed << setprecision(1);
+    cout << "Time: " << report.seconds << " s, " << report.updates / seconds << " results/s\n";
+    cout << "Expected " << report.expected << " games, stored " << report.stored << ", "
+         << report.wrongPlayers << " players wrong\n";
+    bool exact = report.expected == report.updates && report.stored == report.expected && report.wrongPlayers == 0;
+    cout << (exact ? "PASS: no results lost or counted twice\n" : "FAIL: counters do not match\n");
+    return exact ? 0 : 1;
+}
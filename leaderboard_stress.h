@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+// Settings for hammering a ConcurrentLeaderboard from many threads
+struct StressOptions {
+    int threads;
+    int players;
+    long long updates;          // results reported per thread
+    int stripes;                // 1 gives a single-lock baseline
+    std::string leaderboardFile;  // scratch file, emptied first and removed after
+
+    StressOptions();
+};
+
+struct StressReport {
+    long long updates;
+    long long expected;         // wins + losses + draws that should be stored
+    long long stored;
+    int wrongPlayers;           // players whose counters differ from the reference
+    double seconds;
+};
+
+// Every thread reports results for players picked by a fixed sequence and
+// counts its own reference totals; afterwards the file must hold exactly
+// the sum. Returns false if the scratch file cannot be opened.
+bool runLeaderboardStress(const StressOptions& options, StressReport& report);
+
+// Entry point for --stress-leaderboard. Returns 0 only if no result was
+// lost or counted twice.
+int stressMain(int argc, char* argv[]);
@@ -0,0 +1,412 @@
+#include "loadgen.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include "game.h"
+#include "server.h"
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "tictactoe.h"
+#endif
+
+using namespace std;
+
+LoadGenOptions::LoadGenOptions()
+    : host("127.0.0.1"), port(DEFAULT_SERVER_PORT), clients(100), games(10000), pvp(false),
+      difficulty(Difficulty::EASY), boardSize(BOARD_SIZE), winLength(BOARD_SIZE), seed(1) {
+}
+
+#ifdef __linux__
+
+namespace {
+
+const int STALL_SECONDS = 10;
+
+struct Client {
+    int fd;
+    int number;
+    string input;
+    string output;
+    size_t sent;
+    bool waitingToWrite;
+    Position position;
+    char side;
+    bool awaitingReply;         // a move was sent and the answer is still out
+    chrono::steady_clock::time_point moveSent;
+    uint64_t random;
+};
+
+// splitmix64
+uint64_t mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+class LoadGenerator {
+public:
+    explicit LoadGenerator(const LoadGenOptions& options)
+        : options(options), epollFd(-1), requestsLeft(options.pvp ? 2 * options.games : options.games) {
+        report.games = 0;
+        report.moves = 0;
+        report.errors = 0;
+        report.seconds = 0;
+    }
+
+    ~LoadGenerator() {
+        for (auto& entry : clients) ::close(entry.first);
+        if (epollFd >= 0) ::close(epollFd);
+    }
+
+    LoadGenReport run() {
+        rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+        epollFd = epoll_create1(0);
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int i = 0; i < options.clients && requestsLeft > 0; i++) {
+            if (!connectClient(i)) {
+                report.errors++;
+                break;
+            }
+        }
+
+        const int MAX_EVENTS = 256;
+        epoll_event events[MAX_EVENTS];
+        chrono::steady_clock::time_point lastProgress = chrono::steady_clock::now();
+        long long lastMoves = 0;
+        while (!clients.empty()) {
+            int count = epoll_wait(epollFd, events, MAX_EVENTS, 1000);
+            vector<int> closing;
+            for (int i = 0; i < count; i++) {
+                auto entry = clients.find(events[i].data.fd);
+                if (entry == clients.end()) continue;
+                Client& client = entry->second;
+                bool open = !(events[i].events & (EPOLLERR | EPOLLHUP));
+                if (open && (events[i].events & EPOLLOUT)) open = flush(client);
+                if (open && (events[i].events & EPOLLIN)) open = readFrom(client);
+                if (!open) closing.push_back(client.fd);
+            }
+            for (int fd : closing) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                ::close(fd);
+                clients.erase(fd);
+            }
+
+            // Give up if the server stops answering
+            chrono::steady_clock::time_point now = chrono::steady_clock::now();
+            if (report.moves != lastMoves) {
+                lastMoves = report.moves;
+                lastProgress = now;
+            } else if (now - lastProgress > chrono::seconds(STALL_SECONDS)) {
+                cout << "No progress for " << STALL_SECONDS << " s; stopping\n";
+                report.errors += static_cast<long long>(clients.size());
+                break;
+            }
+        }
+
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        report.seconds = elapsed.count();
+        return report;
+    }
+
+private:
+    LoadGenOptions options;
+    int epollFd;
+    long long requestsLeft;
+    unordered_map<int, Client> clients;
+    LoadGenReport report;
+
+    bool connectClient(int number) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.port));
+        if (fd < 0 || inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1 ||
+            connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            cout << "Could not connect to " << options.host << ":" << options.port << "\n";
+            if (fd >= 0) ::close(fd);
+            return false;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+        Client& client = clients[fd];
+        client.fd = fd;
+        client.number = number;
+        client.sent = 0;
+        client.waitingToWrite = false;
+        client.side = ' ';
+        client.awaitingReply = false;
+        client.random = mix(options.seed + static_cast<uint64_t>(number));
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        return requestGame(client);
+    }
+
+    // Ask for the next game, or report that this client is done
+    bool requestGame(Client& client) {
+        if (requestsLeft <= 0) {
+            return false;
+        }
+        requestsLeft--;
+        string board = to_string(options.boardSize) + " " + to_string(options.winLength);
+        if (options.pvp) {
+            return send(client, "NEW PVP " + board);
+        }
+        return send(client, "NEW AI " + board + " " + difficultyName(options.difficulty) + " " +
+                            (client.number % 2 == 0 ? "X" : "O"));
+    }
+
+    // Any empty cell
+    bool playRandomMove(Client& client) {
+        GridMask empty = client.position.geometry().full & ~client.position.cells.occupied();
+        client.random = mix(client.random);
+        int skip = static_cast<int>(client.random % __builtin_popcountll(empty));
+        for (int i = 0; i < skip; i++) {
+            empty &= empty - 1;
+        }
+        int cell = __builtin_ctzll(empty);
+
+        client.position = client.position.play(cell);
+        report.moves++;
+        // The server answers a finishing move with END, not a move
+        client.awaitingReply = !client.position.isOver();
+        client.moveSent = chrono::steady_clock::now();
+        return send(client, "MOVE " + to_string(cell));
+    }
+
+    bool handleLine(Client& client, const string& line) {
+        istringstream words(line);
+        string reply;
+        words >> reply;
+
+        if (reply == "START") {
+            int match;
+            string side;
+            words >> match >> side;
+            client.position = Position(options.boardSize, options.winLength);
+            client.side = side.empty() ? 'X' : side[0];
+            client.awaitingReply = false;
+            if (client.side == 'X') {
+                return playRandomMove(client);
+            }
+        } else if (reply == "MOVE") {
+            int cell = -1;
+            words >> cell;
+            if (client.awaitingReply) {
+                chrono::nanoseconds waited = chrono::steady_clock::now() - client.moveSent;
+                report.latency.record(static_cast<uint64_t>(waited.count()));
+                client.awaitingReply = false;
+            }
+            if (cell < 0 || !client.position.isLegal(cell)) {
+                report.errors++;
+                return false;
+            }
+            client.position = client.position.play(cell);
+            if (!client.position.isOver()) {
+                return playRandomMove(client);
+            }
+        } else if (reply == "END") {
+            string result;
+            words >> result;
+            if (result == "ABANDONED") {
+                report.errors++;
+            } else if (!options.pvp || client.side == 'X') {
+                report.games++;  // a PvP game ends for both of its clients
+            }
+            return requestGame(client);
+        } else if (reply == "ERR") {
+            if (report.errors < 5) cout << "Server error: " << line << "\n";
+            report.errors++;
+            return false;
+        }
+        return true;
+    }
+
+    bool readFrom(Client& client) {
+        char buffer[4096];
+        while (true) {
+            ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                client.input.append(buffer, static_cast<size_t>(received));
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                report.errors++; // The server hung up first
+                return false;
+            }
+            break;
+        }
+
+        size_t start = 0;
+        size_t end;
+        while ((end = client.input.find('\n', start)) != string::npos) {
+            string line = client.input.substr(start, end - start);
+            start = end + 1;
+            if (!handleLine(client, line)) {
+                return false;
+            }
+        }
+        client.input.erase(0, start);
+        return true;
+    }
+
+    bool send(Client& client, const string& line) {
+        client.output += line;
+        client.output += '\n';
+        return flush(client);
+    }
+
+    bool flush(Client& client) {
+        while (client.sent < client.output.size()) {
+            ssize_t written = ::send(client.fd, client.output.data() + client.sent,
+                                     client.output.size() - client.sent, MSG_NOSIGNAL);
+            if (written > 0) {
+                client.sent += static_cast<size_t>(written);
+            } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                report.errors++;
+                return false;
+            }
+        }
+
+        bool pending = client.sent < client.output.size();
+        if (!pending) {
+            client.output.clear();
+            client.sent = 0;
+        }
+        if (pending != client.waitingToWrite) {
+            client.waitingToWrite = pending;
+            epoll_event event = {};
+            event.events = pending ? EPOLLIN | EPOLLOUT : EPOLLIN;
+            event.data.fd = client.fd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+        }
+        return true;
+    }
+};
+
+}
+
+LoadGenReport runLoadGen(const LoadGenOptions& options) {
+    signal(SIGPIPE, SIG_IGN);
+    LoadGenerator generator(options);
+    return generator.run();
+}
+
+#else
+
+LoadGenReport runLoadGen(const LoadGenOptions&) {
+    cout << "The load generator needs Linux (epoll)\n";
+    LoadGenReport report;
+    report.games = 0;
+    report.moves = 0;
+    report.errors = 1;
+    report.seconds = 0;
+    return report;
+}
+
+#endif
+
+namespace {
+
+void printUsage() {
+    cout << "Usage: TicTacToe_Project --loadgen [options]   (start --server first)\n"
+         << "  --host IP         server address (default 127.0.0.1)\n"
+         << "  --port N          server port (default " << DEFAULT_SERVER_PORT << ")\n"
+         << "  --clients N       connections open at once (default 100)\n"
+         << "  --games N         games to play in total (default 10000)\n"
+         << "  --mode ai|pvp     play the server's AI or pair clients up (default ai)\n"
+         << "  --difficulty L    AI level: easy, medium, hard, mcts (default easy)\n"
+         << "  --board N         board size: 3, 5 or 7 (default 3)\n"
+         << "  --win K           marks in a row to win (default for the board)\n"
+         << "  --seed N          seed for the clients' random moves (default 1)\n";
+}
+
+}
+
+int loadGenMain(int argc, char* argv[]) {
+    LoadGenOptions options;
+    bool winGiven = false;
+
+    for (int i = 0; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--help") {
+            printUsage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            cout << "Missing value for " << flag << "\n";
+            printUsage();
+            return 1;
+        }
+        string value = argv[++i];
+        bool valid = true;
+        if (flag == "--host") options.host = value;
+        else if (flag == "--port") options.port = atoi(value.c_str());
+        else if (flag == "--clients") options.clients = atoi(value.c_str());
+        else if (flag == "--games") options.games = atoll(value.c_str());
+        else if (flag == "--mode") { options.pvp = value == "pvp"; valid = options.pvp || value == "ai"; }
+        else if (flag == "--difficulty") valid = parseDifficulty(value, options.difficulty);
+        else if (flag == "--board") options.boardSize = atoi(value.c_str());
+        else if (flag == "--win") { options.winLength = atoi(value.c_str()); winGiven = true; }
+        else if (flag == "--seed") options.seed = strtoull(value.c_str(), nullptr, 10);
+        else valid = false;
+
+        if (!valid) {
+            cout << "Invalid option: " << flag << " " << value << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (!winGiven) {
+        options.winLength = defaultWinLength(options.boardSize);
+    }
+    if (options.boardSize < 3 || options.boardSize > MAX_BOARD_SIZE || options.winLength < 3 ||
+        options.winLength > options.boardSize || options.clients < 1 || options.games < 1) {
+        cout << "Invalid board, win length, client count or game count\n";
+        return 1;
+    }
+
+    cout << "Load test: " << options.games << " " << (options.pvp ? "PvP" : "vs AI") << " games on "
+         << options.boardSize << "x" << options.boardSize << " over " << options.clients
+         << " connections to " << options.host << ":" << options.port << "\n";
+
+    LoadGenReport report = runLoadGen(options);
+
+    double seconds = max(report.seconds, 1e-9);
+    const LatencyHistogram& latency = report.latency;
+    cout << fixed << setprecision(1);
+    cout << "Time: " << report.seconds << " s, " << report.games / seconds << " games/s, "
+         << report.moves / seconds << " moves/s\n";
+    cout << "Games: " << report.games << ", moves sent: " << report.moves << ", errors: " << report.errors << "\n";
+    cout << "Reply latency: mean " << latency.mean() / 1000.0 << " us, p50 " << latency.percentile(0.5) / 1000.0
+         << " us, p99 " << latency.percentile(0.99) / 1000.0 << " us, max " << latency.max() / 1000.0 << " us\n";
+    return report.errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "ai_player.h"
+#include "latency.h"
+
+// Settings for a load test against a running --server
+struct LoadGenOptions {
+    std::string host;
+    int port;
+    int clients;                // connections kept open at once
+    long long games;
+    bool pvp;                   // clients play each other instead of the AI
+    Difficulty difficulty;
+    int boardSize;
+    int winLength;
+    uint64_t seed;
+
+    LoadGenOptions();
+};
+
+struct LoadGenReport {
+    long long games;
+    long long moves;            // moves the clients sent
+    long long errors;           // ERR replies and dropped connections
+    double seconds;
+    LatencyHistogram latency;   // from sending a move to receiving the reply move
+};
+
+// Open the connections and play random legal moves until the games are
+// done. Each client plays its games back to back; in AI games even
+// clients take X and odd clients take O.
+LoadGenReport runLoadGen(const LoadGenOptions& options);
+
+// Entry point for --loadgen: reads the options that follow it, runs the
+// test and prints the report. Returns the process exit code.
+int loadGenMain(int argc, char* argv[]);
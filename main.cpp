@@ -2,25 +2,93 @@
 #include <string>
 #include <cstdlib>
 #include <ctime>
+#include "analyzer.h"
+#include "batch.h"
 #include "game.h"
+#include "leaderboard_stress.h"
+#include "loadgen.h"
+#include "selfplay.h"
+#include "server.h"
+#include "trainer.h"
 
 using namespace std;
 
-int main() {
+int main(int argc, char* argv[]) {
     srand(time(0)); // Seed for random number generation
     
+    // --selfplay [options]: AI-vs-AI games with no terminal interaction
+    if (argc > 1 && string(argv[1]) == "--selfplay") {
+        return selfPlayMain(argc - 2, argv + 2);
+    }
+    
+    // --analyze LOG [options]: judge every move in a game log
+    if (argc > 1 && string(argv[1]) == "--analyze") {
+        return analyzeMain(argc - 2, argv + 2);
+    }
+    
+    // --stress-leaderboard [options]: check concurrent result reporting
+    if (argc > 1 && string(argv[1]) == "--stress-leaderboard") {
+        return stressMain(argc - 2, argv + 2);
+    }
+    
+    // --batch FILE|- [options]: play recorded games into the leaderboard
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        return batchMain(argc - 2, argv + 2);
+    }
+    
+    // --server [options]: host matches over TCP; --loadgen [options]: play against it
+    if (argc > 1 && string(argv[1]) == "--server") {
+        return serverMain(argc - 2, argv + 2);
+    }
+    if (argc > 1 && string(argv[1]) == "--loadgen") {
+        return loadGenMain(argc - 2, argv + 2);
+    }
+    
+    // --train [options]: learn the Medium AI's table by self-play
+    if (argc > 1 && string(argv[1]) == "--train") {
+        return trainMain(argc - 2, argv + 2);
+    }
+    
     Game game;
+    
+    // --threads N: how many threads the AI searches with (default: one per core)
+    // --playouts N: random games the Monte Carlo AI plays per move
+    // --ai-delay MS: shortest pause on the AI's turn (default 1000)
+    // --ai-deadline MS: hard limit on the AI's thinking per move (default 5000, 0 for none)
+    // --stats-json PATH: write the session statistics as JSON on exit
+    // --policy FILE: the table Medium plays 3x3 from (default medium_policy.dat)
+    // --policy-strength N: how closely Medium follows it, 0 to 100 (default 80)
+    for (int i = 1; i + 1 < argc; i++) {
+        if (string(argv[i]) == "--threads") {
+            game.setAIThreads(atoi(argv[++i]));
+        } else if (string(argv[i]) == "--playouts") {
+            game.setAIPlayouts(atoi(argv[++i]));
+        } else if (string(argv[i]) == "--ai-delay") {
+            game.setAIDelay(atoi(argv[++i]));
+        } else if (string(argv[i]) == "--ai-deadline") {
+            game.setAIDeadline(atoi(argv[++i]));
+        } else if (string(argv[i]) == "--stats-json") {
+            game.setStatsFile(argv[++i]);
+        } else if (string(argv[i]) == "--policy") {
+            string path = argv[++i];
+            if (!game.setPolicyFile(path)) {
+                cout << "Warning: could not read " << path << " as a policy table; Medium plays by its rules.\n";
+            }
+        } else if (string(argv[i]) == "--policy-strength") {
+            game.setPolicyStrength(atoi(argv[++i]));
+        }
+    }
     int choice;
     bool exitGame = false;
     
     while (!exitGame) {
         game.showMainMenu();
-        cout << "Enter your choice (1-5): ";
+        cout << "Enter your choice (1-6): ";
         
         if (!(cin >> choice)) {
             cin.clear();
             cin.ignore(10000, '\n');
-            cout << "Invalid input. Please enter a number between 1 and 5.\n";
+            cout << "Invalid input. Please enter a number between 1 and 6.\n";
             continue;
         }
         
@@ -41,11 +109,14 @@ int main() {
                 game.showHelp();
                 break;
             case 5:
+                game.showStats();
+                break;
+            case 6:
                 exitGame = true;
                 cout << "Thanks for playing!\n";
                 break;
             default:
-                cout << "Invalid choice. Please enter a number between 1 and 5.\n";
+                cout << "Invalid choice. Please enter a number between 1 and 6.\n";
         }
     }
     
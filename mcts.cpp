@@ -0,0 +1,286 @@
+#include "mcts.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// Exploration constant of UCT for rewards between 0 and 1
+const double EXPLORATION = 1.4;
+
+// Nodes one tree may hold (16 bytes each); past that, leaves stop being
+// expanded and only their playout statistics grow
+const size_t MAX_TREE_NODES = size_t(1) << 20;
+
+inline char opponentOf(char player) {
+    return player == 'X' ? 'O' : 'X';
+}
+
+// xorshift64*, one generator per tree
+inline uint64_t nextRandom(uint64_t& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+inline bool samePosition(const GridPosition& a, const GridPosition& b) {
+    return a.x == b.x && a.o == b.o;
+}
+
+}
+
+MonteCarloSearch::MonteCarloSearch(const BoardGeometry& geometry) : shape(geometry) {
+}
+
+void MonteCarloSearch::clear() {
+    trees.clear();
+}
+
+// A tree per thread, each with its own random sequence
+void MonteCarloSearch::prepareTrees(int threads) {
+    while (static_cast<int>(trees.size()) < threads) {
+        unique_ptr<Tree> tree(new Tree());
+        tree->player = ' ';
+        tree->random = 0x9E3779B97F4A7C15ULL * (trees.size() + 1);
+        tree->playouts = 0;
+        trees.push_back(move(tree));
+    }
+    if (threads > 1 && (!pool || pool->size() != threads)) {
+        pool.reset(new ThreadPool(threads));
+    }
+}
+
+PlayoutResult MonteCarloSearch::search(const GridPosition& position, char player, const PlayoutLimits& limits) {
+    PlayoutResult result = {-1, 0, 0.0, 0};
+
+    GridMask empty = shape.full & ~position.occupied();
+    if (empty == 0 || shape.hasWin(position.x) || shape.hasWin(position.o)) {
+        return result;
+    }
+
+    int threads = max(1, min(limits.threads, MAX_SEARCH_THREADS));
+    prepareTrees(threads);
+    for (int i = 0; i < threads; i++) {
+        moveRoot(*trees[i], position, player);
+        trees[i]->playouts = 0;
+    }
+
+    // Split the budget evenly; every tree gets at least one playout so the
+    // root is always expanded
+    int budget = max(limits.playouts, threads);
+    vector<ThreadPool::Task> tasks;
+    for (int i = 0; i < threads; i++) {
+        int count = budget / threads + (i < budget % threads ? 1 : 0);
+        Tree* tree = trees[i].get();
+        const StopSignal* stop = limits.stop;
+        tasks.push_back([this, tree, count, stop](int) {
+            for (int n = 0; n < count; n++) {
+                if (stop && n > 0 && (n & 63) == 0 && stop->due()) break;
+                playOnce(*tree);
+            }
+        });
+    }
+    if (threads == 1) {
+        tasks[0](0);
+    } else {
+        pool->run(tasks);
+    }
+
+    // Most visited root move over all trees; ties go to the earlier cell
+    unsigned visits[MAX_CELLS] = {};
+    unsigned long long points[MAX_CELLS] = {};
+    for (int i = 0; i < threads; i++) {
+        const Tree& tree = *trees[i];
+        const Node& root = tree.nodes[0];
+        for (int c = 0; c < root.childCount; c++) {
+            const Node& child = tree.nodes[root.firstChild + c];
+            visits[child.cell] += child.visits;
+            points[child.cell] += child.points;
+        }
+        result.playouts += tree.playouts;
+    }
+    for (int cell = 0; cell < shape.cellTotal; cell++) {
+        if ((empty >> cell & 1) && (result.cell < 0 || visits[cell] > visits[result.cell])) {
+            result.cell = cell;
+        }
+    }
+    result.visits = visits[result.cell];
+    if (result.visits > 0) {
+        result.winRate = points[result.cell] / (2.0 * result.visits);
+    }
+    return result;
+}
+
+// Point the tree at the position to search: keep it as it is, keep the
+// subtree the game actually went down, or start again
+void MonteCarloSearch::moveRoot(Tree& tree, const GridPosition& position, char player) const {
+    if (!tree.nodes.empty() && tree.player == player && samePosition(tree.root, position)) {
+        return;
+    }
+
+    int index = tree.nodes.empty() ? -1 : findDescendant(tree, position, player);
+    if (index < 0) {
+        Node root = {-1, 0, -1, ONGOING, 0, 0};
+        tree.nodes.assign(1, root);
+    } else {
+        // Copy the subtree breadth first, so every child list stays contiguous
+        vector<Node> kept(1, tree.nodes[index]);
+        for (size_t i = 0; i < kept.size(); i++) {
+            int first = kept[i].firstChild;
+            if (first < 0) continue;
+            kept[i].firstChild = static_cast<int32_t>(kept.size());
+            for (int c = 0; c < kept[i].childCount; c++) {
+                kept.push_back(tree.nodes[first + c]);
+            }
+        }
+        tree.nodes.swap(kept);
+    }
+    tree.root = position;
+    tree.player = player;
+}
+
+// Node for the position one or two plies below the root, or -1
+int MonteCarloSearch::findDescendant(const Tree& tree, const GridPosition& position, char player) const {
+    if ((tree.root.x & ~position.x) != 0 || (tree.root.o & ~position.o) != 0) {
+        return -1;
+    }
+
+    const Node& root = tree.nodes[0];
+    for (int c = 0; c < root.childCount && root.firstChild >= 0; c++) {
+        int childIndex = root.firstChild + c;
+        const Node& child = tree.nodes[childIndex];
+        GridPosition afterChild = tree.root;
+        afterChild.place(child.cell, tree.player);
+        if (samePosition(afterChild, position)) {
+            return player == opponentOf(tree.player) ? childIndex : -1;
+        }
+        if (child.outcome != ONGOING) continue;
+
+        for (int g = 0; g < child.childCount && child.firstChild >= 0; g++) {
+            const Node& grandchild = tree.nodes[child.firstChild + g];
+            GridPosition afterGrandchild = afterChild;
+            afterGrandchild.place(grandchild.cell, opponentOf(tree.player));
+            if (samePosition(afterGrandchild, position)) {
+                return player == tree.player ? child.firstChild + g : -1;
+            }
+        }
+    }
+    return -1;
+}
+
+// One iteration: walk down by UCT, expand the leaf on its second visit,
+// finish the game at random and credit every node on the way
+void MonteCarloSearch::playOnce(Tree& tree) {
+    GridPosition position = tree.root;
+    char player = tree.player;
+    int path[MAX_CELLS + 1];
+    int length = 0;
+    int index = 0;
+    path[length++] = index;
+
+    while (tree.nodes[index].outcome == ONGOING) {
+        if (tree.nodes[index].firstChild < 0) {
+            if (index != 0 && tree.nodes[index].visits == 0) break;
+            expand(tree, index, position, player);
+            if (tree.nodes[index].firstChild < 0) break;
+        }
+        index = selectChild(tree, tree.nodes[index]);
+        position.place(tree.nodes[index].cell, player);
+        player = opponentOf(player);
+        path[length++] = index;
+    }
+
+    char winner;
+    const Node& leaf = tree.nodes[index];
+    if (leaf.outcome == WIN) {
+        winner = opponentOf(player);
+    } else if (leaf.outcome == DRAW) {
+        winner = ' ';
+    } else {
+        winner = playout(position, player, tree.random);
+    }
+
+    // The deepest node was moved into by the side not to move now
+    char mover = opponentOf(player);
+    for (int i = length - 1; i >= 0; i--) {
+        Node& node = tree.nodes[path[i]];
+        node.visits++;
+        if (winner == mover) node.points += 2;
+        else if (winner == ' ') node.points += 1;
+        mover = opponentOf(mover);
+    }
+    tree.playouts++;
+}
+
+// Unvisited children first, then the highest upper confidence bound
+int MonteCarloSearch::selectChild(const Tree& tree, const Node& parent) const {
+    double logVisits = log(static_cast<double>(max(parent.visits, 1u)));
+    int best = parent.firstChild;
+    double bestValue = -1.0;
+    for (int c = 0; c < parent.childCount; c++) {
+        const Node& child = tree.nodes[parent.firstChild + c];
+        if (child.visits == 0) {
+            return parent.firstChild + c;
+        }
+        double value = child.points / (2.0 * child.visits) + EXPLORATION * sqrt(logVisits / child.visits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = parent.firstChild + c;
+        }
+    }
+    return best;
+}
+
+// Add a child per empty cell, noting the moves that end the game
+void MonteCarloSearch::expand(Tree& tree, int index, const GridPosition& position, char player) {
+    GridMask occupied = position.occupied();
+    GridMask own = position.cells(player);
+    GridMask empty = shape.full & ~occupied;
+    if (tree.nodes.size() + MAX_CELLS > MAX_TREE_NODES) {
+        return;
+    }
+
+    int32_t first = static_cast<int32_t>(tree.nodes.size());
+    int count = 0;
+    for (int cell = 0; cell < shape.cellTotal; cell++) {
+        if (!(empty >> cell & 1)) continue;
+
+        GridMask bit = GridMask(1) << cell;
+        Outcome outcome = ONGOING;
+        if (shape.completesLine(own | bit, cell)) {
+            outcome = WIN;
+        } else if ((occupied | bit) == shape.full) {
+            outcome = DRAW;
+        }
+        Node child = {-1, 0, static_cast<int8_t>(cell), outcome, 0, 0};
+        tree.nodes.push_back(child);
+        count++;
+    }
+    tree.nodes[index].firstChild = first;
+    tree.nodes[index].childCount = static_cast<uint8_t>(count);
+}
+
+// Uniformly random moves to the end of the game; returns the winner, or
+// ' ' for a draw
+char MonteCarloSearch::playout(GridPosition position, char player, uint64_t& random) const {
+    int cells[MAX_CELLS];
+    int count = 0;
+    GridMask empty = shape.full & ~position.occupied();
+    for (int cell = 0; cell < shape.cellTotal; cell++) {
+        if (empty >> cell & 1) cells[count++] = cell;
+    }
+
+    while (count > 0) {
+        int pick = static_cast<int>(nextRandom(random) % count);
+        int cell = cells[pick];
+        cells[pick] = cells[--count];
+        position.place(cell, player);
+        if (shape.completesLine(position.cells(player), cell)) {
+            return player;
+        }
+        player = opponentOf(player);
+    }
+    return ' ';
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "engine.h"
+#include "thread_pool.h"
+
+// How many random games one decision may play, and on how many threads
+struct PlayoutLimits {
+    int playouts;
+    int threads;
+    const StopSignal* stop;     // ends the playouts early; nullptr for none
+
+    PlayoutLimits() : playouts(20000), threads(1), stop(nullptr) {}
+};
+
+struct PlayoutResult {
+    int cell;                   // -1 if there is no legal move
+    unsigned visits;            // playouts that went through `cell`
+    double winRate;             // for the mover, a draw counting half
+    unsigned long long playouts;
+};
+
+// Monte Carlo tree search with UCT selection and uniformly random
+// playouts. It knows nothing about the board beyond the rules, so a move
+// costs the same whatever the board size and strength comes from the
+// playout budget alone.
+//
+// Each thread grows its own tree (root parallelism) and the visit counts
+// of the root moves are added up at the end. The trees are kept between
+// calls: when the next position is two plies below the last one, the
+// matching subtree becomes the new root and its statistics carry over.
+class MonteCarloSearch {
+public:
+    explicit MonteCarloSearch(const BoardGeometry& geometry);
+
+    PlayoutResult search(const GridPosition& position, char player, const PlayoutLimits& limits);
+    void clear();
+
+private:
+    enum Outcome : uint8_t { ONGOING, WIN, DRAW };
+
+    // Points are from the point of view of the side that moved into the
+    // node: 2 per win and 1 per draw
+    struct Node {
+        int32_t firstChild;     // children are contiguous; -1 until expanded
+        uint8_t childCount;
+        int8_t cell;
+        Outcome outcome;
+        uint32_t visits;
+        uint32_t points;
+    };
+
+    struct Tree {
+        std::vector<Node> nodes;
+        GridPosition root;
+        char player;
+        uint64_t random;
+        unsigned long long playouts;
+    };
+
+    const BoardGeometry& shape;
+    std::vector<std::unique_ptr<Tree> > trees;
+    std::unique_ptr<ThreadPool> pool;
+
+    void prepareTrees(int threads);
+    void moveRoot(Tree& tree, const GridPosition& position, char player) const;
+    int findDescendant(const Tree& tree, const GridPosition& position, char player) const;
+    void playOnce(Tree& tree);
+    int selectChild(const Tree& tree, const Node& parent) const;
+    void expand(Tree& tree, int index, const GridPosition& position, char player);
+    char playout(GridPosition position, char player, uint64_t& random) const;
+};
@@ -0,0 +1,216 @@
+#include "perfect_play.h"
+
+namespace {
+
+constexpr int POSITION_COUNT = 19683;
+constexpr int8_t UNSOLVED = -128;
+
+struct Base3Table {
+    uint16_t code[FULL_BOARD + 1];
+};
+
+// Sum of 3^cell over the set bits of every mask
+constexpr Base3Table buildBase3Table() {
+    Base3Table table{};
+    for (int mask = 0; mask <= FULL_BOARD; mask++) {
+        int code = 0;
+        int power = 1;
+        for (int cell = 0; cell < 9; cell++) {
+            if (mask >> cell & 1) code += power;
+            power *= 3;
+        }
+        table.code[mask] = static_cast<uint16_t>(code);
+    }
+    return table;
+}
+
+constexpr Base3Table BASE3 = buildBase3Table();
+
+struct WinTable {
+    bool wins[FULL_BOARD + 1];
+};
+
+// hasWinLine for every mask, so the compile-time searches below pay one
+// lookup per check instead of a loop over the win lines
+constexpr WinTable buildWinTable() {
+    WinTable table{};
+    for (int mask = 0; mask <= FULL_BOARD; mask++) {
+        table.wins[mask] = hasWinLine(static_cast<BoardMask>(mask));
+    }
+    return table;
+}
+
+constexpr WinTable WINS = buildWinTable();
+
+// Board index: 0 for an empty cell, 1 for X, 2 for O, one base-3 digit per cell
+constexpr int positionIndex(BoardMask x, BoardMask o) {
+    return BASE3.code[x] + 2 * BASE3.code[o];
+}
+
+struct PerfectPlayEntry {
+    int8_t cell;
+    int8_t score;
+};
+
+// One entry per board with O to move. X to move is answered by swapping
+// the colours: the game is symmetric, so X's best move is O's best move
+// on the swapped board and the score just changes sign.
+struct PerfectPlayTable {
+    PerfectPlayEntry entries[POSITION_COUNT];
+};
+
+// Solve a position with O to move and everything below it, memoizing in
+// the table. The recurrence is the full-width minimax of referenceMinimax
+// below, with scores kept relative to the position: a child's score moves
+// one step toward zero per ply.
+constexpr int solve(PerfectPlayTable& table, BoardMask x, BoardMask o) {
+    PerfectPlayEntry& entry = table.entries[positionIndex(x, o)];
+    if (entry.score != UNSOLVED) {
+        return entry.score;
+    }
+
+    int score = 0;
+    int bestCell = -1;
+    if (WINS.wins[o]) {
+        score = 10;
+    } else if (WINS.wins[x]) {
+        score = -10;
+    } else if ((x | o) != FULL_BOARD) {
+        // Ties go to the first cell in row-major order, as in bestMove
+        int bestChild = -1000;
+        for (int cell = 0; cell < 9; cell++) {
+            BoardMask bit = static_cast<BoardMask>(1 << cell);
+            if ((x | o) & bit) continue;
+
+            int child = -solve(table, static_cast<BoardMask>(o | bit), x);
+            if (child > bestChild) {
+                bestChild = child;
+                bestCell = cell;
+            }
+        }
+        score = bestChild > 0 ? bestChild - 1 : bestChild < 0 ? bestChild + 1 : 0;
+    }
+
+    entry.cell = static_cast<int8_t>(bestCell);
+    entry.score = static_cast<int8_t>(score);
+    return score;
+}
+
+// Solving from the empty board reaches every position of both an X-first
+// and an O-first game, since the swapped children cover the other colour
+constexpr PerfectPlayTable buildPerfectPlayTable() {
+    PerfectPlayTable table{};
+    for (int i = 0; i < POSITION_COUNT; i++) {
+        table.entries[i].score = UNSOLVED;
+    }
+    solve(table, 0, 0);
+    return table;
+}
+
+constexpr PerfectPlayTable PERFECT_PLAY = buildPerfectPlayTable();
+
+// Scores of the reference search for every position and side to move.
+// Searching from the empty board, a position is always reached at a depth
+// equal to its number of pieces, so depth needs no slot of its own.
+struct ReferenceTable {
+    int8_t score[2][POSITION_COUNT];
+};
+
+// The reference the table is checked against: a full-width minimax over
+// the cells in row-major order, scoring wins by the depth they are found
+// at, memoized so the compiler can afford it. ClassicSearch, which
+// prunes with alpha-beta and orders its moves, is not the reference.
+constexpr int referenceMinimax(ReferenceTable& memo, BoardMask x, BoardMask o, int depth, bool isMaximizing) {
+    if (WINS.wins[o]) return 10 - depth;
+    if (WINS.wins[x]) return depth - 10;
+    if ((x | o) == FULL_BOARD) return 0;
+
+    int8_t& cached = memo.score[isMaximizing ? 0 : 1][positionIndex(x, o)];
+    if (cached != UNSOLVED) return cached;
+
+    int bestScore = isMaximizing ? -1000 : 1000;
+    for (int cell = 0; cell < 9; cell++) {
+        BoardMask bit = static_cast<BoardMask>(1 << cell);
+        if ((x | o) & bit) continue;
+
+        if (isMaximizing) {
+            int score = referenceMinimax(memo, x, static_cast<BoardMask>(o | bit), depth + 1, false);
+            if (score > bestScore) bestScore = score;
+        } else {
+            int score = referenceMinimax(memo, static_cast<BoardMask>(x | bit), o, depth + 1, true);
+            if (score < bestScore) bestScore = score;
+        }
+    }
+    cached = static_cast<int8_t>(bestScore);
+    return bestScore;
+}
+
+// Compare one position with O to move against the reference search from
+// the start of the game. bestMove scores the children at depth 0
+// rather than depth + 1; that shifts every non-zero score toward zero by
+// the same amount without reaching it, so the chosen cell is the same.
+constexpr bool matchesReference(ReferenceTable& memo, BoardMask x, BoardMask o) {
+    const PerfectPlayEntry& entry = PERFECT_PLAY.entries[positionIndex(x, o)];
+    int depth = cellCount(x) + cellCount(o);
+    int reference = referenceMinimax(memo, x, o, depth, true);
+    int expected = reference > 0 ? reference + depth : reference < 0 ? reference - depth : 0;
+    if (entry.score != expected) {
+        return false;
+    }
+    if (WINS.wins[x] || WINS.wins[o] || (x | o) == FULL_BOARD) {
+        return entry.cell == -1;
+    }
+
+    int bestScore = -1000;
+    int bestCell = -1;
+    for (int cell = 0; cell < 9; cell++) {
+        BoardMask bit = static_cast<BoardMask>(1 << cell);
+        if ((x | o) & bit) continue;
+
+        int score = referenceMinimax(memo, x, static_cast<BoardMask>(o | bit), depth + 1, false);
+        if (score > bestScore) {
+            bestScore = score;
+            bestCell = cell;
+        }
+    }
+    return entry.cell == bestCell;
+}
+
+// Every table entry the solver reached, i.e. every position O can face in
+// a game that X or O started
+constexpr bool tableMatchesMinimax() {
+    ReferenceTable memo{};
+    for (int side = 0; side < 2; side++) {
+        for (int i = 0; i < POSITION_COUNT; i++) {
+            memo.score[side][i] = UNSOLVED;
+        }
+    }
+    referenceMinimax(memo, 0, 0, 0, true);
+    referenceMinimax(memo, 0, 0, 0, false);
+
+    for (int i = 0; i < POSITION_COUNT; i++) {
+        if (PERFECT_PLAY.entries[i].score == UNSOLVED) continue;
+
+        BoardMask x = 0;
+        BoardMask o = 0;
+        for (int cell = 0, code = i; cell < 9; cell++, code /= 3) {
+            if (code % 3 == 1) x |= static_cast<BoardMask>(1 << cell);
+            if (code % 3 == 2) o |= static_cast<BoardMask>(1 << cell);
+        }
+        if (!matchesReference(memo, x, o)) return false;
+    }
+    return true;
+}
+
+static_assert(tableMatchesMinimax(), "perfect-play table disagrees with minimax");
+
+}
+
+PerfectPlay perfectPlay(const Bitboard& board, bool oToMove) {
+    if (oToMove) {
+        const PerfectPlayEntry& entry = PERFECT_PLAY.entries[positionIndex(board.x, board.o)];
+        return PerfectPlay{entry.cell, entry.score};
+    }
+    const PerfectPlayEntry& entry = PERFECT_PLAY.entries[positionIndex(board.o, board.x)];
+    return PerfectPlay{entry.cell, -entry.score};
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "bitboard.h"
+
+// Perfect-play answer for a 3x3 position, read from a table the compiler
+// builds. `cell` is the move ClassicSearch::bestMove would pick (-1 once
+// the game is over) and `score` is the minimax value from O's point of
+// view, on the same scale as ClassicSearch::solve.
+struct PerfectPlay {
+    int cell;
+    int score;
+};
+
+PerfectPlay perfectPlay(const Bitboard& board, bool oToMove);
@@ -0,0 +1,122 @@
+#include "policy_table.h"
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[8] = {'T', 'T', 'T', 'P', 'O', 'L', 'C', 'Y'};
+const int CLASSIC_MASKS = 512;
+
+struct Base3Table {
+    uint16_t code[CLASSIC_MASKS];
+};
+
+// Sum of 3^cell over the set bits of every 3x3 mask
+constexpr Base3Table buildBase3Table() {
+    Base3Table table{};
+    for (int mask = 0; mask < CLASSIC_MASKS; mask++) {
+        int code = 0;
+        int power = 1;
+        for (int cell = 0; cell < 9; cell++) {
+            if (mask >> cell & 1) code += power;
+            power *= 3;
+        }
+        table.code[mask] = static_cast<uint16_t>(code);
+    }
+    return table;
+}
+
+constexpr Base3Table BASE3 = buildBase3Table();
+
+void put32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint32_t get32(const uint8_t* in) {
+    return in[0] | in[1] << 8 | in[2] << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+}
+
+const int8_t PolicyTable::ILLEGAL;
+
+bool PolicyTable::covers(const BoardGeometry& geometry) {
+    return geometry.size == 3 && geometry.winLength == 3 && geometry.layers == 1;
+}
+
+int PolicyTable::stateIndex(GridMask own, GridMask opponent) {
+    return BASE3.code[own] + 2 * BASE3.code[opponent];
+}
+
+void PolicyTable::reset() {
+    values.assign(STATES * CELLS, ILLEGAL);
+    for (int state = 0; state < STATES; state++) {
+        for (int cell = 0, code = state; cell < CELLS; cell++, code /= 3) {
+            if (code % 3 == 0) values[state * CELLS + cell] = 0;
+        }
+    }
+}
+
+void PolicyTable::setValue(int state, int cell, int value) {
+    values[state * CELLS + cell] = static_cast<int8_t>(max(-127, min(127, value)));
+}
+
+// Softmax at temperature (100 - strength) / (strength + 1) on values
+// scaled to [-1, 1]: about 0.25 at strength 80, 1 at 50, 100 at 0
+int PolicyTable::chooseMove(GridMask own, GridMask opponent, int strength, double uniform) const {
+    const int8_t* row = &values[stateIndex(own, opponent) * CELLS];
+    GridMask empty = 0x1FF & ~(own | opponent);
+    if (empty == 0) {
+        return -1;
+    }
+
+    int best = -1;
+    for (GridMask rest = empty; rest; rest &= rest - 1) {
+        int cell = __builtin_ctzll(rest);
+        if (best < 0 || row[cell] > row[best]) best = cell;
+    }
+    if (strength >= 100) {
+        return best;
+    }
+
+    double temperature = (100 - max(0, strength)) / (max(0, strength) + 1.0);
+    double weights[CELLS];
+    double total = 0;
+    for (int cell = 0; cell < CELLS; cell++) {
+        weights[cell] = 0;
+        if (empty >> cell & 1) {
+            weights[cell] = exp((row[cell] - row[best]) / 127.0 / temperature);
+            total += weights[cell];
+        }
+    }
+    double pick = uniform * total;
+    for (int cell = 0; cell < CELLS; cell++) {
+        if (!(empty >> cell & 1)) continue;
+        if (pick < weights[cell]) return cell;
+        pick -= weights[cell];
+    }
+    return best;
+}
+
+vector<uint8_t> PolicyTable::encode() const {
+    vector<uint8_t> bytes(HEADER_BYTES + values.size());
+    memcpy(&bytes[0], MAGIC, sizeof(MAGIC));
+    put32(&bytes[8], FORMAT_VERSION);
+    put32(&bytes[12], static_cast<uint32_t>(values.size() / CELLS));
+    if (!values.empty()) {
+        memcpy(&bytes[HEADER_BYTES], &values[0], values.size());
+    }
+    return bytes;
+}
+
+bool PolicyTable::decode(const vector<uint8_t>& bytes) {
+    if (bytes.size() != HEADER_BYTES + STATES * CELLS || memcmp(&bytes[0], MAGIC, sizeof(MAGIC)) != 0 ||
+        get32(&bytes[8]) != FORMAT_VERSION || get32(&bytes[12]) != static_cast<uint32_t>(STATES)) {
+        return false;
+    }
+    values.resize(STATES * CELLS);
+    memcpy(&values[0], &bytes[HEADER_BYTES], values.size());
+    return true;
+}
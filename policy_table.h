@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "engine.h"
+
+const int DEFAULT_POLICY_STRENGTH = 80;
+
+// Move values for the classic 3x3 board, learned by self-play (see
+// trainer.h) and looked up in O(1). A state is the board as the side to
+// move sees it, one base-3 digit per cell: 0 empty, 1 its own piece, 2 the
+// opponent's, so X and O share every entry. Values run from -127 (the
+// move loses) to 127 (it wins at once); occupied cells hold ILLEGAL.
+//
+// Encoded form (little-endian, version 1): "TTTPOLCY", uint32 version,
+// uint32 state count, then one int8 per cell for every state in index order.
+class PolicyTable {
+public:
+    static const int STATES = 19683;
+    static const int CELLS = 9;
+    static const int8_t ILLEGAL = -128;
+    static const uint32_t FORMAT_VERSION = 1;
+    static const size_t HEADER_BYTES = 16;
+
+    PolicyTable() {}
+
+    bool loaded() const { return !values.empty(); }
+    // Only the plain 3x3 board with three in a row is covered
+    static bool covers(const BoardGeometry& geometry);
+    static int stateIndex(GridMask own, GridMask opponent);
+
+    int value(int state, int cell) const { return values[state * CELLS + cell]; }
+    // Start over with every legal move valued 0
+    void reset();
+    void setValue(int state, int cell, int value);
+
+    // Pick a cell for the side owning `own`. Strength 100 always takes the
+    // best value (the first in row-major order on ties); lower strengths
+    // draw from a softmax over the values that flattens toward uniform at
+    // 0. `uniform` is a random number in [0, 1). -1 if no cell is empty.
+    int chooseMove(GridMask own, GridMask opponent, int strength, double uniform) const;
+
+    std::vector<uint8_t> encode() const;
+    // False if the bytes are not a table of this version
+    bool decode(const std::vector<uint8_t>& bytes);
+
+private:
+    std::vector<int8_t> values;
+};
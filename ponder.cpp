@@ -0,0 +1,179 @@
+#include "ponder.h"
+
+using namespace std;
+
+namespace {
+
+bool samePosition(const Position& a, const Position& b) {
+    return a.shape == b.shape && a.cells.x == b.cells.x && a.cells.o == b.cells.o && a.toMove == b.toMove;
+}
+
+pair<GridMask, GridMask> cellsKey(const GridPosition& cells) {
+    return make_pair(cells.x, cells.o);
+}
+
+}
+
+vector<int> likelyReplies(const Position& position) {
+    const BoardGeometry& shape = position.geometry();
+    vector<int> replies;
+    if (position.isOver()) {
+        return replies;
+    }
+
+    GridMask occupied = position.cells.occupied();
+    GridMask own = position.cells.cells(position.toMove);
+    GridMask opponent = occupied & ~own;
+    GridMask wins = shape.winningCells(own, opponent) & ~occupied;
+    GridMask blocks = shape.winningCells(opponent, own) & ~occupied & ~wins;
+    GridMask near = shape.neighbours(occupied) & ~(wins | blocks);
+    GridMask rest = shape.full & ~occupied & ~(wins | blocks | near);
+
+    const GridMask groups[3] = {blocks, near, rest};
+    for (int g = 0; g < 3; g++) {
+        for (size_t i = 0; i < shape.centerOrder.size(); i++) {
+            int cell = shape.centerOrder[i];
+            if (groups[g] >> cell & 1) replies.push_back(cell);
+        }
+    }
+    return replies;
+}
+
+Ponderer::Ponderer()
+    : job(IDLE), searching(false), stale(false), ponderValid(false), nextReply(0) {
+}
+
+Ponderer::~Ponderer() {
+    {
+        lock_guard<mutex> guard(lock);
+        job = QUIT;
+        stale = true;
+        ponderStop.stopped = true;
+        if (askedSignal) askedSignal->stopped = true;
+    }
+    wake.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void Ponderer::start(const Position& position, const MoveOptions& options) {
+    lock_guard<mutex> guard(lock);
+    if (ponderValid && samePosition(position, pondering)) {
+        return;
+    }
+    if (!worker.joinable()) {
+        worker = thread(&Ponderer::run, this);
+    }
+
+    // Whatever is being searched belongs to an earlier position
+    if (searching) {
+        stale = true;
+        ponderStop.stopped = true;
+    }
+    answers.clear();
+    pondering = position;
+    ponderOptions = options;
+    ponderValid = true;
+    replies = likelyReplies(position);
+    nextReply = 0;
+    job = PONDER;
+    wake.notify_one();
+}
+
+MoveFuture Ponderer::answer(const Position& position, const MoveOptions& options, int deadlineMs, bool& pondered) {
+    shared_ptr<StopSignal> signal = stopSignalAfter(deadlineMs);
+    unique_lock<mutex> guard(lock);
+    if (!worker.joinable()) {
+        worker = thread(&Ponderer::run, this);
+    }
+
+    // Take no more replies. One being searched is let finish only if it is
+    // the one that was played, and then only until the deadline.
+    if (job == PONDER) job = IDLE;
+    if (searching && !(searchingFor.x == position.cells.x && searchingFor.o == position.cells.o)) {
+        stale = true;
+        ponderStop.stopped = true;
+    }
+    if (deadlineMs > 0 && !done.wait_until(guard, signal->deadline, [this] { return !searching; })) {
+        ponderStop.stopped = true;
+    }
+    done.wait(guard, [this] { return !searching; });
+    ponderValid = false;
+
+    map<pair<GridMask, GridMask>, AIMove>::iterator found = answers.find(cellsKey(position.cells));
+    pondered = found != answers.end() && found->second.cell >= 0;
+    promise<AIMove> ready;
+    if (pondered) {
+        ready.set_value(found->second);
+        answers.clear();
+        return MoveFuture(ready.get_future(), signal);
+    }
+    answers.clear();
+
+    asked = position;
+    askedOptions = options;
+    askedOptions.settings.stop = signal.get();
+    askedSignal = signal;
+    reply = move(ready);
+    job = ANSWER;
+    wake.notify_one();
+    return MoveFuture(reply.get_future(), signal);
+}
+
+void Ponderer::stop() {
+    lock_guard<mutex> guard(lock);
+    if (job == PONDER) job = IDLE;
+    if (searching) {
+        stale = true;
+        ponderStop.stopped = true;
+    }
+    ponderValid = false;
+    answers.clear();
+}
+
+// One search per wake-up: the asked position, or the next pondered reply
+void Ponderer::run() {
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [this] { return job != IDLE; });
+        if (job == QUIT) {
+            return;
+        }
+
+        if (job == ANSWER) {
+            Position position = asked;
+            MoveOptions options = askedOptions;
+            shared_ptr<StopSignal> signal = askedSignal;
+            promise<AIMove> answered = move(reply);
+            job = IDLE;
+            guard.unlock();
+            answered.set_value(bestMove(position, options));
+            guard.lock();
+            askedSignal.reset();
+            continue;
+        }
+
+        if (nextReply == replies.size()) {
+            job = IDLE;
+            continue;
+        }
+        Position position = pondering.play(replies[nextReply++]);
+        MoveOptions options = ponderOptions;
+        options.settings.stop = &ponderStop;
+        searching = true;
+        searchingFor = position.cells;
+        stale = false;
+        ponderStop.stopped = false;
+        guard.unlock();
+
+        AIMove move = bestMove(position, options);
+
+        guard.lock();
+        searching = false;
+        if (!stale) {
+            answers[cellsKey(position.cells)] = move;
+        }
+        done.notify_all();
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "tictactoe.h"
+
+// Cells the side to move is most likely to play next: blocks of the
+// other side's threats first, then cells next to pieces from the middle
+// outwards, then the rest. Moves that win on the spot are left out, since
+// they leave nothing to answer.
+std::vector<int> likelyReplies(const Position& position);
+
+// Thinks about the AI's next move while its opponent chooses theirs.
+// start() takes the position with the opponent to move; a background
+// thread then searches the AI's answer to each likely reply in turn and
+// keeps them. answer() takes the position after the real reply and hands
+// back the kept answer, ready at once, if that reply was covered.
+// Otherwise the search runs on the background thread, whose transposition
+// tables are warm from the replies it did look at, and the MoveFuture
+// answers by the deadline.
+//
+// Searches go through bestMove, whose caches belong to the calling
+// thread, so all the AI's moves in a game should come from one Ponderer.
+class Ponderer {
+public:
+    Ponderer();
+    ~Ponderer();
+
+    // Start pondering the replies to `position`; the AI will answer with
+    // `options`. Asking again for the same position keeps what was found.
+    void start(const Position& position, const MoveOptions& options);
+    // The AI's move in `position`, due `deadlineMs` from now (0 for no
+    // deadline); `pondered` tells whether it was ready
+    MoveFuture answer(const Position& position, const MoveOptions& options, int deadlineMs, bool& pondered);
+    // Stop searching and forget what was pondered
+    void stop();
+
+private:
+    enum Job { IDLE, PONDER, ANSWER, QUIT };
+
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;       // new job for the worker
+    std::condition_variable done;       // a search finished
+    Job job;
+    bool searching;                     // a search is running outside the lock
+    GridPosition searchingFor;
+    StopSignal ponderStop;              // ends the running ponder search
+    bool stale;                         // and its answer is not wanted
+
+    Position pondering;                 // opponent to move
+    MoveOptions ponderOptions;
+    bool ponderValid;
+    std::vector<int> replies;
+    size_t nextReply;
+    std::map<std::pair<GridMask, GridMask>, AIMove> answers;
+
+    Position asked;
+    MoveOptions askedOptions;
+    std::shared_ptr<StopSignal> askedSignal;
+    std::promise<AIMove> reply;
+
+    void run();
+};
@@ -0,0 +1,186 @@
+#include "rank_index.h"
+#include <algorithm>
+
+using namespace std;
+
+RankIndex::RankIndex() : root(-1), isBuilt(false), random(0x9E3779B97F4A7C15ULL) {
+}
+
+void RankIndex::build(const LeaderboardStore& store) {
+    int count = store.size();
+    nodes.assign(count, Node());
+    vector<int> order(count);
+    for (int i = 0; i < count; i++) {
+        const PlayerRecord& record = store.at(i);
+        nodes[i] = Node{-1, -1, 1, nextPriority(), record.wins, record.wins + record.losses + record.draws, true};
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [this](int a, int b) { return before(a, b); });
+
+    // Cartesian tree over the sorted players: each new node takes the
+    // lower-priority tail of the right spine as its left subtree
+    vector<int> spine;
+    for (int node : order) {
+        int last = -1;
+        while (!spine.empty() && nodes[spine.back()].priority < nodes[node].priority) {
+            last = spine.back();
+            spine.pop_back();
+        }
+        nodes[node].left = last;
+        if (!spine.empty()) nodes[spine.back()].right = node;
+        spine.push_back(node);
+    }
+    root = spine.empty() ? -1 : spine.front();
+    computeSizes(root);
+    isBuilt = true;
+}
+
+void RankIndex::clear() {
+    nodes.clear();
+    root = -1;
+    isBuilt = false;
+}
+
+void RankIndex::update(int player, const PlayerRecord& record) {
+    if (player >= static_cast<int>(nodes.size())) {
+        nodes.resize(player + 1, Node{-1, -1, 1, 0, 0, 0, false});
+    }
+    if (nodes[player].ranked) {
+        root = erase(root, player);
+    }
+
+    Node& node = nodes[player];
+    node = Node{-1, -1, 1, nextPriority(), record.wins, record.wins + record.losses + record.draws, true};
+    int less, rest;
+    split(root, player, less, rest);
+    root = merge(merge(less, player), rest);
+}
+
+int RankIndex::select(int rank) const {
+    int tree = root;
+    while (tree >= 0) {
+        const Node& node = nodes[tree];
+        int leftSize = node.left < 0 ? 0 : nodes[node.left].size;
+        if (rank < leftSize) {
+            tree = node.left;
+        } else if (rank == leftSize) {
+            return tree;
+        } else {
+            rank -= leftSize + 1;
+            tree = node.right;
+        }
+    }
+    return -1;
+}
+
+int RankIndex::rankOf(int player) const {
+    if (player < 0 || player >= static_cast<int>(nodes.size()) || !nodes[player].ranked) {
+        return -1;
+    }
+    int rank = 0;
+    int tree = root;
+    while (tree >= 0) {
+        const Node& node = nodes[tree];
+        int leftSize = node.left < 0 ? 0 : nodes[node.left].size;
+        if (tree == player) {
+            return rank + leftSize;
+        }
+        if (before(player, tree)) {
+            tree = node.left;
+        } else {
+            rank += leftSize + 1;
+            tree = node.right;
+        }
+    }
+    return -1;
+}
+
+vector<int> RankIndex::range(int first, int count) const {
+    vector<int> players;
+    for (int rank = max(first, 0); rank < first + count && rank < size(); rank++) {
+        players.push_back(select(rank));
+    }
+    return players;
+}
+
+// Higher win rate first, then more wins, then whoever joined first.
+// Rates are compared as fractions so no rounding can reorder them.
+bool RankIndex::before(int a, int b) const {
+    const Node& x = nodes[a];
+    const Node& y = nodes[b];
+    int64_t left = int64_t(x.wins) * max(y.games, 1);
+    int64_t right = int64_t(y.wins) * max(x.games, 1);
+    if (left != right) return left > right;
+    if (x.wins != y.wins) return x.wins > y.wins;
+    return a < b;
+}
+
+// xorshift64
+uint32_t RankIndex::nextPriority() {
+    random ^= random << 13;
+    random ^= random >> 7;
+    random ^= random << 17;
+    return static_cast<uint32_t>(random >> 32);
+}
+
+void RankIndex::resize(int node) {
+    Node& n = nodes[node];
+    n.size = 1 + (n.left < 0 ? 0 : nodes[n.left].size) + (n.right < 0 ? 0 : nodes[n.right].size);
+}
+
+// Split a tree into the players ranked before `key` and the rest
+void RankIndex::split(int tree, int key, int& less, int& rest) {
+    if (tree < 0) {
+        less = rest = -1;
+        return;
+    }
+    if (before(tree, key)) {
+        split(nodes[tree].right, key, nodes[tree].right, rest);
+        less = tree;
+    } else {
+        split(nodes[tree].left, key, less, nodes[tree].left);
+        rest = tree;
+    }
+    resize(tree);
+}
+
+// Join two trees where every player in `left` ranks before every one in `right`
+int RankIndex::merge(int left, int right) {
+    if (left < 0) return right;
+    if (right < 0) return left;
+    if (nodes[left].priority > nodes[right].priority) {
+        nodes[left].right = merge(nodes[left].right, right);
+        resize(left);
+        return left;
+    }
+    nodes[right].left = merge(left, nodes[right].left);
+    resize(right);
+    return right;
+}
+
+// Remove the player `key`, found by its current counters
+int RankIndex::erase(int tree, int key) {
+    if (tree < 0) {
+        return -1;
+    }
+    if (tree == key) {
+        nodes[key].ranked = false;
+        return merge(nodes[tree].left, nodes[tree].right);
+    }
+    if (before(key, tree)) {
+        nodes[tree].left = erase(nodes[tree].left, key);
+    } else {
+        nodes[tree].right = erase(nodes[tree].right, key);
+    }
+    resize(tree);
+    return tree;
+}
+
+int RankIndex::computeSizes(int tree) {
+    if (tree < 0) {
+        return 0;
+    }
+    Node& node = nodes[tree];
+    node.size = 1 + computeSizes(node.left) + computeSizes(node.right);
+    return node.size;
+}
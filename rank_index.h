@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "leaderboard_store.h"
+
+// Players ordered by win rate, then wins, then the order they joined, kept
+// in a treap where every node knows its subtree size. Moving one player
+// after a game, the player at a given rank and the rank of a given player
+// all take O(log n) expected time.
+//
+// Players are named by their record number in the LeaderboardStore, which
+// is also their node number here. Building the index reads every record,
+// so it is done on first use rather than at start-up.
+class RankIndex {
+public:
+    RankIndex();
+
+    bool built() const { return isBuilt; }
+    // Rank every player in the store: a sort plus a linear-time treap build
+    void build(const LeaderboardStore& store);
+    // Forget everything; the next build starts over
+    void clear();
+
+    // Insert a player, or move one whose counters changed
+    void update(int player, const PlayerRecord& record);
+
+    int size() const { return root < 0 ? 0 : nodes[root].size; }
+    // Player at a 0-based rank
+    int select(int rank) const;
+    // 0-based rank of a player, or -1 if it is not ranked
+    int rankOf(int player) const;
+    // Players ranked first .. first + count - 1, best first
+    std::vector<int> range(int first, int count) const;
+
+private:
+    struct Node {
+        int left;
+        int right;
+        int size;
+        uint32_t priority;
+        int32_t wins;
+        int32_t games;
+        bool ranked;
+    };
+
+    std::vector<Node> nodes;
+    int root;
+    bool isBuilt;
+    uint64_t random;
+
+    bool before(int a, int b) const;
+    uint32_t nextPriority();
+    void resize(int node);
+    void split(int tree, int key, int& less, int& rest);
+    int merge(int left, int right);
+    int erase(int tree, int key);
+    int computeSizes(int tree);
+};
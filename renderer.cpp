@@ -0,0 +1,238 @@
+#include "renderer.h"
+#include <iostream>
+#include <cstdio>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const char CLEAR_SCREEN[] = "\033[2J\033[H";
+const char CLEAR_TO_END[] = "\033[J";
+
+// Screen layout of displayBoard, 1-based: the column numbers on row 2,
+// then four rows per board row, the mark in the middle of each cell.
+// Layers get the layer names on row 2 and two rows per board row, each
+// layer LAYER_WIDTH columns right of the one before.
+const int LAYER_WIDTH = 22;
+
+int cellRow(int row, int layers) {
+    return layers > 1 ? 5 + 2 * row : 5 + 4 * row;
+}
+
+int cellColumn(int column, int layer, int layers) {
+    return layers > 1 ? 6 + LAYER_WIDTH * layer + 4 * column : 9 + 8 * column;
+}
+
+// First row under the board and the blank line after it
+int statusRow(int size, int layers) {
+    return layers > 1 ? 6 + 2 * size : 5 + 4 * size;
+}
+
+// Height of the terminal, or 0 if it is not known
+int terminalRows() {
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+        return info.srWindow.Bottom - info.srWindow.Top + 1;
+    }
+#else
+    winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) {
+        return size.ws_row;
+    }
+#endif
+    return 0;
+}
+
+}
+
+TerminalRenderer::TerminalRenderer() : shownSize(0), shownLayers(0) {
+#ifdef _WIN32
+    // Windows 10 consoles understand ANSI escapes once asked to
+    HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode;
+    if (GetConsoleMode(output, &mode)) {
+        SetConsoleMode(output, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }
+#endif
+}
+
+void TerminalRenderer::clear() {
+    frame = CLEAR_SCREEN;
+    shown.clear();
+    shownSize = 0;
+    shownLayers = 0;
+    write();
+}
+
+void TerminalRenderer::drawBoard(const GridPosition& board, int size, int layers, const string& status) {
+    frame.clear();
+
+    // Patch the board in place only if it is still where it was drawn:
+    // a screen too short for the board and the text under it scrolls
+    int rows = terminalRows();
+    bool fits = rows == 0 || statusRow(size, layers) + 4 <= rows;
+    if (size == shownSize && layers == shownLayers && fits) {
+        int area = size * size;
+        for (int cell = 0; cell < layers * area; cell++) {
+            char mark = board.at(cell);
+            if (mark == shown[cell]) continue;
+            appendMoveTo(cellRow(cell / size % size, layers), cellColumn(cell % size, cell / area, layers));
+            appendSymbol(mark);
+            shown[cell] = mark;
+        }
+        appendMoveTo(statusRow(size, layers), 1);
+        frame += CLEAR_TO_END;
+    } else {
+        frame = CLEAR_SCREEN;
+        if (layers > 1) {
+            appendLayers(board, size, layers);
+        } else {
+            appendFullBoard(board, size);
+        }
+        shownLayers = layers;
+    }
+
+    frame += status;
+    write();
+}
+
+// The whole board, as the original cout version drew it
+void TerminalRenderer::appendFullBoard(const GridPosition& board, int size) {
+    string separator = "    +";
+    string padding = "    |";
+    for (int j = 0; j < size; j++) {
+        separator += "-------+";
+        padding += "       |";
+    }
+    separator += "\n";
+    padding += "\n";
+
+    frame += "\n    ";
+    for (int j = 0; j < size; j++) {
+        frame += "    ";
+        frame += static_cast<char>('1' + j);
+        if (j < size - 1) frame += "   ";
+    }
+    frame += "\n";
+    frame += separator;
+
+    shown.assign(size * size, ' ');
+    for (int i = 0; i < size; i++) {
+        frame += padding;
+        frame += " ";
+        frame += static_cast<char>('1' + i);
+        frame += "  |";
+        for (int j = 0; j < size; j++) {
+            char mark = board.at(i * size + j);
+            frame += "   ";
+            appendSymbol(mark);
+            frame += "   |";
+            shown[i * size + j] = mark;
+        }
+        frame += "\n";
+        frame += padding;
+        frame += separator;
+    }
+    frame += "\n";
+    shownSize = size;
+}
+
+// Every layer as a compact grid, left to right
+void TerminalRenderer::appendLayers(const GridPosition& board, int size, int layers) {
+    string separator = "   +";
+    string numbers = "   ";
+    for (int j = 0; j < size; j++) {
+        separator += "---+";
+        numbers += "  ";
+        numbers += static_cast<char>('1' + j);
+        numbers += " ";
+    }
+    string gap(LAYER_WIDTH - separator.size(), ' ');
+
+    frame += "\n";
+    for (int layer = 0; layer < layers; layer++) {
+        string title = "   Layer " + to_string(layer + 1);
+        frame += title + string(LAYER_WIDTH - title.size(), ' ');
+    }
+    frame += "\n";
+    for (int layer = 0; layer < layers; layer++) {
+        frame += numbers + string(LAYER_WIDTH - numbers.size(), ' ');
+    }
+    frame += "\n";
+    for (int layer = 0; layer < layers; layer++) {
+        frame += separator + gap;
+    }
+    frame += "\n";
+
+    int area = size * size;
+    shown.assign(layers * area, ' ');
+    for (int i = 0; i < size; i++) {
+        for (int layer = 0; layer < layers; layer++) {
+            frame += " ";
+            frame += static_cast<char>('1' + i);
+            frame += " |";
+            for (int j = 0; j < size; j++) {
+                int cell = layer * area + i * size + j;
+                char mark = board.at(cell);
+                frame += " ";
+                appendSymbol(mark);
+                frame += " |";
+                shown[cell] = mark;
+            }
+            frame += gap;
+        }
+        frame += "\n";
+        for (int layer = 0; layer < layers; layer++) {
+            frame += separator + gap;
+        }
+        frame += "\n";
+    }
+    frame += "\n";
+    shownSize = size;
+}
+
+// X in blue, O in red
+void TerminalRenderer::appendSymbol(char cell) {
+    if (cell == 'X') {
+        frame += "\033[1;34mX\033[0m";
+    } else if (cell == 'O') {
+        frame += "\033[1;31mO\033[0m";
+    } else {
+        frame += ' ';
+    }
+}
+
+void TerminalRenderer::appendMoveTo(int row, int column) {
+    char sequence[32];
+    snprintf(sequence, sizeof(sequence), "\033[%d;%dH", row, column);
+    frame += sequence;
+}
+
+// One write for the whole frame, after anything still buffered in cout
+void TerminalRenderer::write() {
+    cout.flush();
+    fflush(stdout);
+    const char* data = frame.data();
+    size_t left = frame.size();
+    while (left > 0) {
+#ifdef _WIN32
+        int written = _write(1, data, static_cast<unsigned int>(left));
+#else
+        ssize_t written = ::write(STDOUT_FILENO, data, left);
+#endif
+        if (written <= 0) break;
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "engine.h"
+
+// Draws the game board with ANSI escape sequences. Each frame is built in
+// one buffer and written with a single call. While the same board stays
+// on screen only the cells that changed are redrawn, by moving the cursor
+// to them, and the text under the board is replaced; nothing is cleared,
+// so the screen does not flicker.
+//
+// Anything else written to the terminal may move the board, so callers
+// that draw other screens call clear() first, which also makes the next
+// board frame a full one. A board with several layers is drawn as one
+// smaller grid per layer, side by side.
+class TerminalRenderer {
+public:
+    TerminalRenderer();
+
+    // Wipe the screen and put the cursor in the top-left corner
+    void clear();
+    // Show the board with `status` (any number of lines) underneath
+    void drawBoard(const GridPosition& board, int size, int layers, const std::string& status);
+
+private:
+    std::string frame;
+    std::vector<char> shown;        // cells on screen; empty if no board is
+    int shownSize;
+    int shownLayers;
+
+    void appendFullBoard(const GridPosition& board, int size);
+    void appendLayers(const GridPosition& board, int size, int layers);
+    void appendSymbol(char cell);
+    void appendMoveTo(int row, int column);
+    void write();
+};
@@ -0,0 +1,251 @@
+#include "selfplay.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "game.h"
+#include "thread_pool.h"
+#include "trainer.h"
+
+using namespace std;
+
+namespace {
+
+// Results of the games one worker played
+struct WorkerTally {
+    long long xWins;
+    long long oWins;
+    long long draws;
+    LatencyHistogram latency[2];
+
+    WorkerTally() : xWins(0), oWins(0), draws(0) {}
+};
+
+// splitmix64, so each game's opening depends only on the seed and its number
+uint64_t mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// Play one game to the end; returns the winner or ' ' for a draw
+char playGame(const SelfPlayOptions& options, const BoardGeometry& geometry, AIPlayer* players[2],
+              long long number, WorkerTally& tally, GameRecord& record) {
+    GridPosition position;
+    char player = number % 2 == 0 ? 'X' : 'O';
+    record.firstPlayer = player;
+    record.openingMoves = 0;
+    record.moveCount = 0;
+    uint64_t random = mix(options.seed ^ static_cast<uint64_t>(number));
+
+    for (int ply = 0; ply < geometry.cellTotal; ply++) {
+        int cell;
+        if (ply < options.openingMoves) {
+            // Any empty cell, from the game's own generator
+            GridMask empty = geometry.full & ~position.occupied();
+            random = mix(random);
+            int skip = static_cast<int>(random % __builtin_popcountll(empty));
+            for (int i = 0; i < skip; i++) {
+                empty &= empty - 1;
+            }
+            cell = __builtin_ctzll(empty);
+        } else {
+            int side = player == 'X' ? 0 : 1;
+            Difficulty difficulty = side == 0 ? options.x : options.o;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            cell = players[side]->chooseMove(position, player, difficulty, options.ai).cell;
+            chrono::nanoseconds spent = chrono::steady_clock::now() - start;
+            tally.latency[side].record(static_cast<uint64_t>(spent.count()));
+        }
+
+        position.place(cell, player);
+        record.moves[record.moveCount++] = static_cast<uint8_t>(cell);
+        if (ply < options.openingMoves) record.openingMoves = record.moveCount;
+        if (geometry.completesLine(position.cells(player), cell)) {
+            return player;
+        }
+        player = player == 'X' ? 'O' : 'X';
+    }
+    return ' ';
+}
+
+void printLatency(const char* label, const LatencyHistogram& latency) {
+    cout << "  " << label << ": " << latency.count() << " moves, mean "
+         << fixed << setprecision(1) << latency.mean() / 1000.0 << " us, p50 "
+         << latency.percentile(0.5) / 1000.0 << " us, p99 "
+         << latency.percentile(0.99) / 1000.0 << " us, max "
+         << latency.max() / 1000.0 << " us\n";
+}
+
+void printUsage() {
+    cout << "Usage: TicTacToe_Project --selfplay [options]\n"
+         << "  --games N         games to play (default 10000)\n"
+         << "  --board N         board size: 3, 5 or 7 (default 3)\n"
+         << "  --win K           marks in a row to win (default for the board)\n"
+         << "  --x LEVEL         X difficulty: easy, medium, hard, mcts (default hard)\n"
+         << "  --o LEVEL         O difficulty (default hard)\n"
+         << "  --workers N       threads playing games (default: one per core)\n"
+         << "  --openings N      random moves at the start of each game (default 1)\n"
+         << "  --seed N          seed for the random openings (default 1)\n"
+         << "  --time-budget MS  alpha-beta time per move on large boards (default 10)\n"
+         << "  --playouts N      Monte Carlo playouts per move (default 1000)\n"
+         << "  --log FILE        append every game to a binary game log\n"
+         << "  --policy FILE     table Medium plays 3x3 from (made by --train)\n"
+         << "  --policy-strength N  how closely Medium follows it, 0-100 (default 80)\n";
+}
+
+}
+
+SelfPlayOptions::SelfPlayOptions()
+    : games(10000), boardSize(BOARD_SIZE), winLength(BOARD_SIZE), x(Difficulty::HARD), o(Difficulty::HARD),
+      workers(max(1, static_cast<int>(thread::hardware_concurrency()))), openingMoves(1), seed(1) {
+    ai.timeBudgetMs = 10;
+    ai.playouts = 1000;
+}
+
+SelfPlayReport runSelfPlay(const SelfPlayOptions& options, GameLogWriter* log) {
+    const BoardGeometry& geometry = BoardGeometry::get(options.boardSize, options.winLength);
+    int workers = max(1, options.workers);
+    vector<WorkerTally> tallies(workers);
+
+    // Worker w plays games w, w + workers, ... with its own pair of AIs,
+    // so no state is shared while the games run
+    vector<ThreadPool::Task> tasks;
+    for (int w = 0; w < workers; w++) {
+        tasks.push_back([&, w](int) {
+            AIPlayer xPlayer(geometry, mix(options.seed + 2 * w));
+            AIPlayer oPlayer(geometry, mix(options.seed + 2 * w + 1));
+            AIPlayer* players[2] = {&xPlayer, &oPlayer};
+            WorkerTally& tally = tallies[w];
+            GameRecord record;
+            record.xLevel = static_cast<int8_t>(options.x);
+            record.oLevel = static_cast<int8_t>(options.o);
+            record.boardSize = static_cast<uint8_t>(geometry.size);
+            record.winLength = static_cast<uint8_t>(geometry.winLength);
+            for (long long number = w; number < options.games; number += workers) {
+                char winner = playGame(options, geometry, players, number, tally, record);
+                if (winner == 'X') tally.xWins++;
+                else if (winner == 'O') tally.oWins++;
+                else tally.draws++;
+                if (log) {
+                    record.timestamp = GameRecord::now();
+                    record.result = winner == ' ' ? 'D' : winner;
+                    log->append(record);
+                }
+            }
+        });
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    ThreadPool pool(workers);
+    pool.run(tasks);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    SelfPlayReport report;
+    report.games = options.games;
+    report.xWins = 0;
+    report.oWins = 0;
+    report.draws = 0;
+    report.seconds = elapsed.count();
+    for (int w = 0; w < workers; w++) {
+        report.xWins += tallies[w].xWins;
+        report.oWins += tallies[w].oWins;
+        report.draws += tallies[w].draws;
+        report.latency[0].merge(tallies[w].latency[0]);
+        report.latency[1].merge(tallies[w].latency[1]);
+    }
+    return report;
+}
+
+int selfPlayMain(int argc, char* argv[]) {
+    SelfPlayOptions options;
+    bool winGiven = false;
+    string policyFile;
+    PolicyTable policy;
+
+    for (int i = 0; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--help") {
+            printUsage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            cout << "Missing value for " << flag << "\n";
+            printUsage();
+            return 1;
+        }
+        string value = argv[++i];
+        bool valid = true;
+        if (flag == "--games") options.games = atoll(value.c_str());
+        else if (flag == "--board") options.boardSize = atoi(value.c_str());
+        else if (flag == "--win") { options.winLength = atoi(value.c_str()); winGiven = true; }
+        else if (flag == "--x") valid = parseDifficulty(value, options.x);
+        else if (flag == "--o") valid = parseDifficulty(value, options.o);
+        else if (flag == "--workers") options.workers = atoi(value.c_str());
+        else if (flag == "--openings") options.openingMoves = atoi(value.c_str());
+        else if (flag == "--seed") options.seed = strtoull(value.c_str(), nullptr, 10);
+        else if (flag == "--time-budget") options.ai.timeBudgetMs = atoi(value.c_str());
+        else if (flag == "--playouts") options.ai.playouts = atoi(value.c_str());
+        else if (flag == "--log") options.logFile = value;
+        else if (flag == "--policy") policyFile = value;
+        else if (flag == "--policy-strength") options.ai.policyStrength = max(0, min(atoi(value.c_str()), 100));
+        else valid = false;
+
+        if (!valid) {
+            cout << "Invalid option: " << flag << " " << value << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (!winGiven) {
+        options.winLength = defaultWinLength(options.boardSize);
+    }
+    if (options.boardSize < 3 || options.boardSize > MAX_BOARD_SIZE ||
+        options.winLength < 3 || options.winLength > options.boardSize ||
+        options.games < 0 || options.workers < 1 ||
+        options.openingMoves < 0 || options.openingMoves >= options.boardSize * options.boardSize) {
+        cout << "Invalid board, win length, game count, worker count or opening length\n";
+        return 1;
+    }
+    if (!options.logFile.empty() && options.openingMoves > MAX_OPENING_MOVES) {
+        cout << "A game log can mark at most " << MAX_OPENING_MOVES << " opening moves\n";
+        return 1;
+    }
+
+    if (!policyFile.empty()) {
+        if (!loadPolicyTable(policyFile, policy)) {
+            cout << "Could not read " << policyFile << " as a policy table\n";
+            return 1;
+        }
+        options.ai.policy = &policy;
+    }
+
+    cout << "Self-play: " << options.games << " games on " << options.boardSize << "x" << options.boardSize
+         << " (" << options.winLength << " in a row), X " << difficultyName(options.x)
+         << " vs O " << difficultyName(options.o) << ", " << options.workers << " workers\n";
+
+    GameLogWriter log(options.logFile);
+    if (!options.logFile.empty() && !log.open()) {
+        cout << "Could not open " << options.logFile << " as a game log\n";
+        return 1;
+    }
+    SelfPlayReport report = runSelfPlay(options, log.isOpen() ? &log : nullptr);
+    log.close();
+
+    double games = report.games > 0 ? static_cast<double>(report.games) : 1.0;
+    cout << fixed << setprecision(1);
+    cout << "Time: " << report.seconds << " s, " << report.games / report.seconds << " games/s\n";
+    cout << "X wins: " << report.xWins << " (" << 100.0 * report.xWins / games << "%)\n";
+    cout << "O wins: " << report.oWins << " (" << 100.0 * report.oWins / games << "%)\n";
+    cout << "Draws:  " << report.draws << " (" << 100.0 * report.draws / games << "%)\n";
+    cout << "Move latency:\n";
+    printLatency("X", report.latency[0]);
+    printLatency("O", report.latency[1]);
+    return 0;
+}
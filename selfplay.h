@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "ai_player.h"
+#include "gamelog.h"
+#include "latency.h"
+
+// Settings for a batch of AI-vs-AI games
+struct SelfPlayOptions {
+    long long games;
+    int boardSize;
+    int winLength;
+    Difficulty x;
+    Difficulty o;
+    int workers;                // games are spread over this many threads
+    int openingMoves;           // random moves before the AIs take over
+    uint64_t seed;
+    AISettings ai;              // per AI; its threads stay at 1
+    std::string logFile;        // game log to append to; empty for none
+
+    SelfPlayOptions();
+};
+
+struct SelfPlayReport {
+    long long games;
+    long long xWins;
+    long long oWins;
+    long long draws;
+    double seconds;
+    LatencyHistogram latency[2];  // per move, X then O
+};
+
+// Play the games without any terminal I/O. Game i starts with X when i
+// is even and with O when it is odd, after the opening moves, which are
+// drawn from a generator seeded by the game number. Each finished game is
+// appended to `log` if one is given.
+SelfPlayReport runSelfPlay(const SelfPlayOptions& options, GameLogWriter* log = nullptr);
+
+// Entry point for --selfplay: reads the options that follow it, plays and
+// prints the report. Returns the process exit code.
+int selfPlayMain(int argc, char* argv[]);
@@ -0,0 +1,693 @@
+#include "server.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#ifdef __linux__
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "concurrent_leaderboard.h"
+#include "gamelog.h"
+#include "latency.h"
+#include "tictactoe.h"
+#endif
+
+using namespace std;
+
+ServerOptions::ServerOptions()
+    : port(DEFAULT_SERVER_PORT), workers(max(1, static_cast<int>(thread::hardware_concurrency()))),
+      moveDeadlineMs(0) {
+    ai.timeBudgetMs = 100;
+    ai.playouts = 2000;
+}
+
+#ifdef __linux__
+
+namespace {
+
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
+}
+
+// A search the event loop handed to the move workers
+struct MoveJob {
+    int match;
+    int ply;                    // the answer is dropped if the match moved on
+    Position position;
+    MoveOptions options;
+    chrono::steady_clock::time_point queued;
+    chrono::steady_clock::time_point deadline;  // the search answers by then
+};
+
+struct MoveDone {
+    int match;
+    int ply;
+    int cell;
+    uint64_t nanoseconds;       // from queued to found
+};
+
+// Threads that run AI searches for the event loop. Finished moves are
+// collected in a list and the loop is woken through an eventfd.
+class MoveWorkers {
+public:
+    MoveWorkers(int count, int wakeFd) : wakeFd(wakeFd), stopping(false) {
+        for (int i = 0; i < count; i++) {
+            threads.emplace_back([this] { work(); });
+        }
+    }
+
+    ~MoveWorkers() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& worker : threads) {
+            worker.join();
+        }
+    }
+
+    void submit(const MoveJob& job) {
+        {
+            lock_guard<mutex> guard(lock);
+            jobs.push_back(job);
+        }
+        wake.notify_one();
+    }
+
+    // Move every finished search into `finished`
+    void takeFinished(vector<MoveDone>& finished) {
+        lock_guard<mutex> guard(lock);
+        finished.swap(done);
+        done.clear();
+    }
+
+private:
+    int wakeFd;
+    vector<thread> threads;
+    mutex lock;
+    condition_variable wake;
+    deque<MoveJob> jobs;
+    vector<MoveDone> done;
+    bool stopping;
+
+    void work() {
+        while (true) {
+            MoveJob job;
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [this] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = jobs.front();
+                jobs.pop_front();
+            }
+
+            StopSignal stop;
+            stop.deadline = job.deadline;
+            job.options.settings.stop = &stop;
+            int cell = bestMove(job.position, job.options).cell;
+            chrono::nanoseconds spent = chrono::steady_clock::now() - job.queued;
+            {
+                lock_guard<mutex> guard(lock);
+                done.push_back(MoveDone{job.match, job.ply, cell, static_cast<uint64_t>(spent.count())});
+            }
+            uint64_t one = 1;
+            ssize_t written = write(wakeFd, &one, sizeof(one));
+            (void)written;
+        }
+    }
+};
+
+struct Connection {
+    int fd;
+    string input;
+    string output;
+    size_t sent;                // bytes of `output` already written
+    bool waitingToWrite;        // EPOLLOUT is armed
+    bool closing;
+    int match;                  // -1 when not in a match
+    pair<int, int> waitingFor;  // board (size, win) awaited for PvP; (0, 0) when not waiting
+    string name;                // given with the last NEW; empty for none
+};
+
+struct Match {
+    int id;
+    Position position;
+    int ply;
+    int players[2];             // connection of X and of O; -1 for the AI
+    string names[2];            // leaderboard names of X and of O; empty for none
+    Difficulty difficulty;
+    GameRecord record;          // for the game log
+};
+
+// splitmix64, for the AI's per-match seeds
+uint64_t mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Thousands of connections need more descriptors than the usual soft limit
+void raiseOpenFileLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+class Server {
+public:
+    explicit Server(const ServerOptions& options)
+        : options(options), log(options.logFile), store(options.leaderboardFile), epollFd(-1), listenFd(-1), wakeFd(-1), nextMatch(1),
+          accepted(0), matchesStarted(0), matchesFinished(0), moves(0) {}
+
+    ~Server() {
+        workers.reset();
+        for (auto& entry : connections) ::close(entry.first);
+        if (listenFd >= 0) ::close(listenFd);
+        if (wakeFd >= 0) ::close(wakeFd);
+        if (epollFd >= 0) ::close(epollFd);
+    }
+
+    int run() {
+        if (!options.logFile.empty() && !log.open()) {
+            cout << "Could not open " << options.logFile << " as a game log\n";
+            return 1;
+        }
+        if (!options.leaderboardFile.empty()) {
+            if (!store.open()) {
+                cout << "Could not open " << options.leaderboardFile << " as a leaderboard\n";
+                return 1;
+            }
+            results.reset(new ConcurrentLeaderboard(store));
+        }
+        if (!listen()) {
+            return 1;
+        }
+        cout << "Serving on 127.0.0.1:" << options.port << " with " << options.workers
+             << " AI workers; Ctrl+C to stop\n";
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        const int MAX_EVENTS = 256;
+        epoll_event events[MAX_EVENTS];
+        while (!stopRequested) {
+            int count = epoll_wait(epollFd, events, MAX_EVENTS, 500);
+            for (int i = 0; i < count; i++) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptAll();
+                } else if (fd == wakeFd) {
+                    finishAIMoves();
+                } else {
+                    auto entry = connections.find(fd);
+                    if (entry == connections.end()) continue;
+                    Connection& connection = entry->second;
+                    // Commands still buffered when the peer hangs up are
+                    // handled before the connection is marked closing
+                    bool hungUp = (events[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+                    if (events[i].events & EPOLLOUT) flush(connection);
+                    if ((events[i].events & EPOLLIN) || hungUp) readFrom(connection);
+                    if (hungUp) connection.closing = true;
+                }
+            }
+            closeFinished();
+        }
+
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        printReport(elapsed.count());
+        return 0;
+    }
+
+private:
+    ServerOptions options;
+    GameLogWriter log;
+    LeaderboardStore store;
+    unique_ptr<ConcurrentLeaderboard> results;  // counts named players' results; null without a leaderboard
+    int epollFd;
+    int listenFd;
+    int wakeFd;
+    unique_ptr<MoveWorkers> workers;
+    unordered_map<int, Connection> connections;
+    unordered_map<int, Match> matches;
+    map<pair<int, int>, int> waiting;  // board (size, win) -> connection waiting for PvP
+    int nextMatch;
+
+    long long accepted;
+    long long matchesStarted;
+    long long matchesFinished;
+    long long moves;
+    LatencyHistogram aiLatency;
+
+    bool listen() {
+        raiseOpenFileLimit();
+        epollFd = epoll_create1(0);
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        wakeFd = eventfd(0, EFD_NONBLOCK);
+        if (epollFd < 0 || listenFd < 0 || wakeFd < 0) {
+            cout << "Could not create the server sockets\n";
+            return false;
+        }
+
+        int on = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listenFd, SOMAXCONN) != 0 || !setNonBlocking(listenFd)) {
+            cout << "Could not listen on port " << options.port << "\n";
+            return false;
+        }
+
+        watch(listenFd, EPOLLIN, EPOLL_CTL_ADD);
+        watch(wakeFd, EPOLLIN, EPOLL_CTL_ADD);
+        workers.reset(new MoveWorkers(max(1, options.workers), wakeFd));
+        return true;
+    }
+
+    void watch(int fd, uint32_t events, int operation) {
+        epoll_event event = {};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, operation, fd, &event);
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd < 0) return;
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            connections[fd] = Connection{fd, string(), string(), 0, false, false, -1, make_pair(0, 0), string()};
+            watch(fd, EPOLLIN, EPOLL_CTL_ADD);
+            accepted++;
+        }
+    }
+
+    // Take in everything the client sent and act on each complete line;
+    // a client that closes its end right after its last command still has
+    // those commands answered before the connection goes
+    void readFrom(Connection& connection) {
+        char buffer[4096];
+        bool ended = false;
+        while (true) {
+            ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                connection.input.append(buffer, static_cast<size_t>(received));
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                ended = true;
+            }
+            break;
+        }
+
+        size_t start = 0;
+        size_t end;
+        while (!connection.closing && (end = connection.input.find('\n', start)) != string::npos) {
+            string line = connection.input.substr(start, end - start);
+            if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+            start = end + 1;
+            handleLine(connection, line);
+        }
+        connection.input.erase(0, start);
+        if (connection.input.size() > 4096) {
+            connection.closing = true; // No command is that long
+        }
+        if (ended) {
+            connection.closing = true;
+        }
+    }
+
+    void handleLine(Connection& connection, const string& line) {
+        istringstream words(line);
+        string command;
+        words >> command;
+
+        if (command == "NEW") {
+            string mode;
+            int size = 0;
+            int winLength = 0;
+            words >> mode >> size >> winLength;
+            if (connection.match >= 0) {
+                send(connection, "ERR already in a match");
+            } else if (connection.waitingFor.first != 0) {
+                send(connection, "ERR already waiting");
+            } else if (size < 3 || size > MAX_BOARD_SIZE || winLength < 3 || winLength > size) {
+                send(connection, "ERR bad board");
+            } else if (mode == "AI") {
+                string level;
+                string side;
+                string name;
+                Difficulty difficulty;
+                words >> level >> side >> name;
+                if (!parseDifficulty(level, difficulty) || (side != "X" && side != "O")) {
+                    send(connection, "ERR usage: NEW AI <size> <win> <level> <X|O> [name]");
+                } else if (name.size() > static_cast<size_t>(MAX_NAME_LENGTH)) {
+                    send(connection, "ERR name too long");
+                } else {
+                    connection.name = name;
+                    startAIMatch(connection, size, winLength, difficulty, side[0]);
+                }
+            } else if (mode == "PVP") {
+                string name;
+                words >> name;
+                if (name.size() > static_cast<size_t>(MAX_NAME_LENGTH)) {
+                    send(connection, "ERR name too long");
+                } else {
+                    connection.name = name;
+                    startPvPMatch(connection, size, winLength);
+                }
+            } else {
+                send(connection, "ERR usage: NEW AI|PVP ...");
+            }
+        } else if (command == "MOVE") {
+            int cell = -1;
+            words >> cell;
+            playMove(connection, cell);
+        } else if (command == "QUIT") {
+            connection.closing = true;
+        } else {
+            send(connection, "ERR unknown command");
+        }
+    }
+
+    Match& createMatch(int size, int winLength, int xPlayer, int oPlayer, Difficulty difficulty) {
+        Match& match = matches[nextMatch];
+        match.id = nextMatch++;
+        match.position = Position(size, winLength);
+        match.ply = 0;
+        match.players[0] = xPlayer;
+        match.players[1] = oPlayer;
+        match.names[0] = xPlayer < 0 ? string() : connections[xPlayer].name;
+        match.names[1] = oPlayer < 0 ? string() : connections[oPlayer].name;
+        match.difficulty = difficulty;
+        match.record = GameRecord();
+        match.record.boardSize = static_cast<uint8_t>(size);
+        match.record.winLength = static_cast<uint8_t>(winLength);
+        match.record.xLevel = static_cast<int8_t>(xPlayer < 0 ? static_cast<int>(difficulty) : HUMAN_LEVEL);
+        match.record.oLevel = static_cast<int8_t>(oPlayer < 0 ? static_cast<int>(difficulty) : HUMAN_LEVEL);
+        matchesStarted++;
+        return match;
+    }
+
+    void startAIMatch(Connection& connection, int size, int winLength, Difficulty difficulty, char side) {
+        Match& match = side == 'X' ? createMatch(size, winLength, connection.fd, -1, difficulty)
+                                   : createMatch(size, winLength, -1, connection.fd, difficulty);
+        connection.match = match.id;
+        send(connection, "START " + to_string(match.id) + " " + side);
+        if (side == 'O') {
+            requestAIMove(match);
+        }
+    }
+
+    void startPvPMatch(Connection& connection, int size, int winLength) {
+        auto board = make_pair(size, winLength);
+        auto entry = waiting.find(board);
+        if (entry == waiting.end()) {
+            waiting[board] = connection.fd;
+            connection.waitingFor = board;
+            send(connection, "WAIT");
+            return;
+        }
+
+        Connection& opponent = connections[entry->second];
+        waiting.erase(entry);
+        opponent.waitingFor = make_pair(0, 0);
+        Match& match = createMatch(size, winLength, opponent.fd, connection.fd, Difficulty::HARD);
+        opponent.match = match.id;
+        connection.match = match.id;
+        send(opponent, "START " + to_string(match.id) + " X");
+        send(connection, "START " + to_string(match.id) + " O");
+    }
+
+    void playMove(Connection& connection, int cell) {
+        auto entry = matches.find(connection.match);
+        if (entry == matches.end()) {
+            send(connection, "ERR not in a match");
+            return;
+        }
+        Match& match = entry->second;
+        int side = match.position.toMove == 'X' ? 0 : 1;
+        if (match.players[side] != connection.fd) {
+            send(connection, "ERR not your turn");
+        } else if (cell < 0 || !match.position.isLegal(cell)) {
+            send(connection, "ERR illegal move");
+        } else {
+            applyMove(match, cell);
+        }
+    }
+
+    // Play a move, tell the other side, and either end the match or pass
+    // the turn on
+    void applyMove(Match& match, int cell) {
+        match.position = match.position.play(cell);
+        match.ply++;
+        match.record.moves[match.record.moveCount++] = static_cast<uint8_t>(cell);
+        moves++;
+
+        int next = match.players[match.position.toMove == 'X' ? 0 : 1];
+        auto opponent = connections.find(next);
+        if (opponent != connections.end()) {
+            send(opponent->second, "MOVE " + to_string(cell));
+        }
+        if (match.position.isOver()) {
+            char winner = match.position.winner();
+            endMatch(match, winner == ' ' ? "DRAW" : string(1, winner));
+        } else if (next < 0) {
+            requestAIMove(match);
+        }
+    }
+
+    void requestAIMove(const Match& match) {
+        MoveJob job;
+        job.match = match.id;
+        job.ply = match.ply;
+        job.position = match.position;
+        job.options.difficulty = match.difficulty;
+        job.options.settings = options.ai;
+        job.options.settings.threads = 1;
+        job.options.seed = mix(static_cast<uint64_t>(match.id) << 8 | static_cast<uint64_t>(match.ply));
+        job.queued = chrono::steady_clock::now();
+        job.deadline = options.moveDeadlineMs > 0 ? job.queued + chrono::milliseconds(options.moveDeadlineMs)
+                                                  : chrono::steady_clock::time_point::max();
+        workers->submit(job);
+    }
+
+    void finishAIMoves() {
+        uint64_t count;
+        ssize_t readBytes = read(wakeFd, &count, sizeof(count));
+        (void)readBytes;
+
+        vector<MoveDone> finished;
+        workers->takeFinished(finished);
+        for (const MoveDone& done : finished) {
+            aiLatency.record(done.nanoseconds);
+            auto entry = matches.find(done.match);
+            // The player may have left while the AI was thinking
+            if (entry == matches.end() || entry->second.ply != done.ply || done.cell < 0) continue;
+            applyMove(entry->second, done.cell);
+        }
+    }
+
+    void endMatch(Match& match, const string& result) {
+        for (int side = 0; side < 2; side++) {
+            int fd = match.players[side];
+            if (fd < 0) continue;
+            auto entry = connections.find(fd);
+            if (entry == connections.end()) continue;
+            entry->second.match = -1;
+            send(entry->second, "END " + result);
+        }
+        if (log.isOpen()) {
+            match.record.timestamp = GameRecord::now();
+            match.record.result = result == "DRAW" ? 'D' : result.size() == 1 ? result[0] : ' ';
+            log.append(match.record);
+        }
+        if (results && result != "ABANDONED") {
+            for (int side = 0; side < 2; side++) {
+                if (match.names[side].empty()) continue;
+                char own = side == 0 ? 'X' : 'O';
+                GameOutcome outcome = result == "DRAW" ? GameOutcome::DRAW
+                                      : result[0] == own ? GameOutcome::WIN : GameOutcome::LOSS;
+                results->record(match.names[side], outcome);
+            }
+        }
+        matchesFinished++;
+        matches.erase(match.id);
+    }
+
+    void send(Connection& connection, const string& line) {
+        connection.output += line;
+        connection.output += '\n';
+        flush(connection);
+    }
+
+    void flush(Connection& connection) {
+        while (connection.sent < connection.output.size()) {
+            ssize_t written = ::send(connection.fd, connection.output.data() + connection.sent,
+                                     connection.output.size() - connection.sent, MSG_NOSIGNAL);
+            if (written > 0) {
+                connection.sent += static_cast<size_t>(written);
+            } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                connection.closing = true;
+                return;
+            }
+        }
+
+        bool pending = connection.sent < connection.output.size();
+        if (!pending) {
+            connection.output.clear();
+            connection.sent = 0;
+        }
+        // Only wait for the socket to drain while there is something to send
+        if (pending != connection.waitingToWrite) {
+            connection.waitingToWrite = pending;
+            watch(connection.fd, pending ? EPOLLIN | EPOLLOUT : EPOLLIN, EPOLL_CTL_MOD);
+        }
+    }
+
+    // Close the connections marked during this round of events; an
+    // opponent left behind in a PvP match is told the match is over
+    void closeFinished() {
+        vector<int> closing;
+        for (auto& entry : connections) {
+            if (entry.second.closing) closing.push_back(entry.first);
+        }
+        for (int fd : closing) {
+            Connection& connection = connections[fd];
+            auto entry = matches.find(connection.match);
+            if (entry != matches.end()) {
+                connection.match = -1;
+                endMatch(entry->second, "ABANDONED");
+            }
+            // The fd may be reused by the next connection, so it must not
+            // be left waiting for any board
+            for (auto wait = waiting.begin(); wait != waiting.end();) {
+                if (wait->second == fd) wait = waiting.erase(wait);
+                else ++wait;
+            }
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            ::close(fd);
+            connections.erase(fd);
+        }
+    }
+
+    void printReport(double seconds) {
+        cout << "\nServer stopped after " << fixed << setprecision(1) << seconds << " s\n";
+        cout << "Connections: " << accepted << ", matches started: " << matchesStarted
+             << ", finished: " << matchesFinished << "\n";
+        cout << "Moves: " << moves << " (" << moves / max(seconds, 1e-9) << " per second)\n";
+        cout << "AI moves: " << aiLatency.count() << ", queue + search mean "
+             << aiLatency.mean() / 1000.0 << " us, p50 " << aiLatency.percentile(0.5) / 1000.0
+             << " us, p99 " << aiLatency.percentile(0.99) / 1000.0 << " us, max "
+             << aiLatency.max() / 1000.0 << " us\n";
+    }
+};
+
+void printUsage() {
+    cout << "Usage: TicTacToe_Project --server [options]\n"
+         << "  --port N          TCP port on 127.0.0.1 (default " << DEFAULT_SERVER_PORT << ")\n"
+         << "  --workers N       threads running AI searches (default: one per core)\n"
+         << "  --time-budget MS  alpha-beta time per move on large boards (default 100)\n"
+         << "  --playouts N      Monte Carlo playouts per move (default 2000)\n"
+         << "  --deadline MS     hard limit per AI move, queueing included (default: none)\n"
+         << "  --log FILE        append every match to a binary game log\n"
+         << "  --leaderboard FILE  count named players' results in a leaderboard (default: none)\n";
+}
+
+}
+
+int runServer(const ServerOptions& options) {
+    stopRequested = 0;
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    signal(SIGPIPE, SIG_IGN);
+    Server server(options);
+    return server.run();
+}
+
+#else
+
+namespace {
+
+void printUsage() {
+    cout << "Usage: TicTacToe_Project --server [--port N] [--workers N] [--time-budget MS] [--playouts N] [--deadline MS]\n"
+         << "       [--log FILE] [--leaderboard FILE]\n";
+}
+
+}
+
+int runServer(const ServerOptions&) {
+    cout << "Server mode needs Linux (epoll)\n";
+    return 1;
+}
+
+#endif
+
+int serverMain(int argc, char* argv[]) {
+    ServerOptions options;
+    for (int i = 0; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--help") {
+            printUsage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            cout << "Missing value for " << flag << "\n";
+            printUsage();
+            return 1;
+        }
+        string text = argv[++i];
+        int value = atoi(text.c_str());
+        if (flag == "--port") options.port = value;
+        else if (flag == "--workers") options.workers = value;
+        else if (flag == "--time-budget") options.ai.timeBudgetMs = value;
+        else if (flag == "--playouts") options.ai.playouts = value;
+        else if (flag == "--deadline") options.moveDeadlineMs = value;
+        else if (flag == "--log") options.logFile = text;
+        else if (flag == "--leaderboard") options.leaderboardFile = text;
+        else {
+            cout << "Invalid option: " << flag << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (options.port <= 0 || options.port > 65535 || options.workers < 1) {
+        cout << "Invalid port or worker count\n";
+        return 1;
+    }
+    return runServer(options);
+}
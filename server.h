@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include "ai_player.h"
+
+const int DEFAULT_SERVER_PORT = 7878;
+
+// Server mode hosts many matches at once over TCP on localhost: one
+// epoll event loop owns every socket and match, and AI searches run on
+// a pool of worker threads that hand their moves back to the loop, so a
+// slow search never holds up other players. Linux only.
+//
+// Line protocol, one command or reply per '\n'-terminated line; cells are
+// numbered row * size + col from 0.
+//   client: NEW AI <size> <win> <easy|medium|hard|mcts> <X|O> [name]
+//                                  play the AI, taking side X or O
+//           NEW PVP <size> <win> [name]
+//                                  play the next client asking for the
+//                                  same board; no other NEW until then
+//           MOVE <cell>            play a move in the current match
+//           QUIT                   close the connection
+//   server: WAIT                   waiting for a PvP opponent
+//           START <match> <X|O>    the match began; X moves first
+//           MOVE <cell>            the opponent's move
+//           END <X|O|DRAW|ABANDONED>
+//           ERR <reason>           the command was refused
+// A player who gives a name (up to 31 characters) has the match's result
+// counted on the leaderboard, if the server keeps one.
+struct ServerOptions {
+    int port;
+    int workers;                // threads running AI searches
+    AISettings ai;              // per search; its threads stay at 1
+    int moveDeadlineMs;         // hard limit per AI move from when it was asked for; 0 for none
+    std::string logFile;        // game log to append every match to; empty for none
+    std::string leaderboardFile;    // leaderboard for named players' results; empty for none
+
+    ServerOptions();
+};
+
+// Run until SIGINT or SIGTERM, then print statistics. Returns the process
+// exit code.
+int runServer(const ServerOptions& options);
+
+// Entry point for --server: reads the options that follow it
+int serverMain(int argc, char* argv[]);
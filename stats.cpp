@@ -0,0 +1,114 @@
+#include "stats.h"
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+// {"count":..,"mean":..,"p50":..,"p99":..,"max":..}, times in microseconds
+// unless the histogram counts something else
+string histogramJson(const LatencyHistogram& histogram, double scale) {
+    ostringstream json;
+    json << fixed << setprecision(3) << "{\"count\": " << histogram.count()
+         << ", \"mean\": " << histogram.mean() / scale
+         << ", \"p50\": " << histogram.percentile(0.5) / scale
+         << ", \"p99\": " << histogram.percentile(0.99) / scale
+         << ", \"max\": " << histogram.max() / scale << "}";
+    return json.str();
+}
+
+// Count, mean, p50, p99 and max on one line, divided by `scale`
+void summaryLine(ostringstream& text, const string& label, const LatencyHistogram& histogram, double scale) {
+    text << "  " << left << setw(18) << label << right << setw(8) << histogram.count()
+         << "  mean " << histogram.mean() / scale << ", p50 " << histogram.percentile(0.5) / scale
+         << ", p99 " << histogram.percentile(0.99) / scale << ", max " << histogram.max() / scale << "\n";
+}
+
+}
+
+GameStats::GameStats()
+    : started(chrono::steady_clock::now()), tableProbes(0), tableHits(0), playouts(0), ponderHits(0),
+      ponderMisses(0), games(0), moves(0) {
+}
+
+void GameStats::recordDecision(Difficulty difficulty, uint64_t nanoseconds, const AIMove& move) {
+    decisionLatency[static_cast<int>(difficulty)].record(nanoseconds);
+    if (move.nodes > 0) {
+        searchNodes.record(move.nodes);
+    }
+    tableProbes += move.tableProbes;
+    tableHits += move.tableHits;
+    playouts += move.playouts;
+}
+
+void GameStats::recordGame(int gameMoves) {
+    games++;
+    moves += gameMoves;
+}
+
+double GameStats::sessionSeconds() const {
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - started;
+    return elapsed.count();
+}
+
+string GameStats::summary() const {
+    double seconds = sessionSeconds();
+    double hitRate = tableProbes > 0 ? 100.0 * tableHits / tableProbes : 0.0;
+    ostringstream text;
+    text << fixed << setprecision(1);
+    text << "Session: " << seconds << " s, " << games << " games, " << moves << " moves ("
+         << games * 3600.0 / max(seconds, 1e-9) << " games/hour)\n";
+    text << "AI decision time (us):\n";
+    for (int d = 0; d < DIFFICULTY_COUNT; d++) {
+        if (decisionLatency[d].count() > 0) {
+            summaryLine(text, difficultyName(static_cast<Difficulty>(d)), decisionLatency[d], 1e3);
+        }
+    }
+    text << "Search:\n";
+    summaryLine(text, "nodes/decision", searchNodes, 1.0);
+    text << "  table hit rate    " << hitRate << "% of " << tableProbes << " probes\n";
+    text << "  playouts          " << playouts << "\n";
+    text << "  pondered answers  " << ponderHits << " of " << ponderHits + ponderMisses << "\n";
+    text << "Leaderboard (us):\n";
+    summaryLine(text, "load", leaderboardLoad, 1e3);
+    summaryLine(text, "save", leaderboardSave, 1e3);
+    return text.str();
+}
+
+string GameStats::toJson() const {
+    double seconds = sessionSeconds();
+    ostringstream json;
+    json << fixed << setprecision(3);
+    json << "{\n  \"session_seconds\": " << seconds
+         << ",\n  \"games\": " << games
+         << ",\n  \"moves\": " << moves
+         << ",\n  \"games_per_hour\": " << games * 3600.0 / max(seconds, 1e-9)
+         << ",\n  \"decision_latency_us\": {";
+    for (int d = 0; d < DIFFICULTY_COUNT; d++) {
+        json << (d > 0 ? "," : "") << "\n    \"" << difficultyName(static_cast<Difficulty>(d)) << "\": "
+             << histogramJson(decisionLatency[d], 1e3);
+    }
+    json << "\n  },\n  \"search_nodes_per_decision\": " << histogramJson(searchNodes, 1.0)
+         << ",\n  \"table_probes\": " << tableProbes
+         << ",\n  \"table_hits\": " << tableHits
+         << ",\n  \"table_hit_rate\": " << (tableProbes > 0 ? static_cast<double>(tableHits) / tableProbes : 0.0)
+         << ",\n  \"playouts\": " << playouts
+         << ",\n  \"ponder_hits\": " << ponderHits
+         << ",\n  \"ponder_misses\": " << ponderMisses
+         << ",\n  \"leaderboard_load_us\": " << histogramJson(leaderboardLoad, 1e3)
+         << ",\n  \"leaderboard_save_us\": " << histogramJson(leaderboardSave, 1e3)
+         << "\n}\n";
+    return json.str();
+}
+
+bool GameStats::writeJson(const string& path) const {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    string json = toJson();
+    bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+    return fclose(file) == 0 && written;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "ai_player.h"
+#include "latency.h"
+
+const int DIFFICULTY_COUNT = 4;
+
+// Always-on counters for a game session: per AI decision a clock read and
+// a few additions into fixed histograms, so they stay enabled in release
+// builds. Shown from the menu and written as JSON for comparing builds.
+class GameStats {
+public:
+    GameStats();
+
+    // One AI move: time from asking to answer, and the search's counters
+    void recordDecision(Difficulty difficulty, uint64_t nanoseconds, const AIMove& move);
+    // Whether a pondered AI move was ready when the human moved
+    void recordPonder(bool hit) { (hit ? ponderHits : ponderMisses)++; }
+    void recordLeaderboardLoad(uint64_t nanoseconds) { leaderboardLoad.record(nanoseconds); }
+    void recordLeaderboardSave(uint64_t nanoseconds) { leaderboardSave.record(nanoseconds); }
+    // A finished game and the moves it took
+    void recordGame(int moves);
+
+    // Plain-text report for the Statistics screen
+    std::string summary() const;
+    // Everything as one JSON object
+    std::string toJson() const;
+    // Write toJson() to a file; false if it cannot be written
+    bool writeJson(const std::string& path) const;
+
+private:
+    std::chrono::steady_clock::time_point started;
+    LatencyHistogram decisionLatency[DIFFICULTY_COUNT];
+    LatencyHistogram searchNodes;       // per decision that ran the alpha-beta search
+    unsigned long long tableProbes;
+    unsigned long long tableHits;
+    unsigned long long playouts;
+    long long ponderHits;
+    long long ponderMisses;
+    LatencyHistogram leaderboardLoad;
+    LatencyHistogram leaderboardSave;
+    long long games;
+    long long moves;
+
+    double sessionSeconds() const;
+};
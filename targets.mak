@@ -0,0 +1,34 @@
+# Extra targets, included by Makefile.win through the project's MakeIncludes.
+
+# Engine library: make -f Makefile.win library
+# The AI and the board rules with no console or file I/O, for embedding;
+# include tictactoe.h and link libtictactoe.a.
+
+LIBRARY     = libtictactoe.a
+LIBRARY_OBJ = tictactoe.o ai_player.o classic_search.o engine.o mcts.o perfect_play.o transposition.o thread_pool.o win_batch.o ponder.o policy_table.o
+
+.PHONY: library bench
+
+library: $(LIBRARY)
+
+$(LIBRARY): $(LIBRARY_OBJ)
+	${RM} $(LIBRARY)
+	ar rcs $(LIBRARY) $(LIBRARY_OBJ)
+
+# Benchmark executable: make -f Makefile.win bench
+# It links every project object except main.o, so for meaningful numbers
+# build the project with optimization on (-O2).
+
+BENCH_BIN = TicTacToe_Bench.exe
+BENCH_OBJ = bench/bench.o $(filter-out main.o,$(OBJ))
+
+bench: $(BENCH_BIN)
+
+$(BENCH_BIN): $(BENCH_OBJ)
+	$(CPP) $(BENCH_OBJ) -o $(BENCH_BIN) $(LIBS)
+
+bench/bench.o: bench/bench.cpp
+	$(CPP) -c bench/bench.cpp -o bench/bench.o $(CXXFLAGS) -O2
+
+clean-custom:
+	${RM} bench/bench.o $(BENCH_BIN) $(LIBRARY)
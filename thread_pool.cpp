@@ -0,0 +1,83 @@
+#include "thread_pool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(int threadCount) : generation(0), pending(0), stopping(false) {
+    if (threadCount < 1) threadCount = 1;
+    for (int i = 0; i < threadCount; i++) {
+        queues.push_back(unique_ptr<Queue>(new Queue()));
+    }
+    for (int i = 0; i < threadCount; i++) {
+        workers.push_back(thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
+
+// Deal the tasks out round-robin, in order, so each worker starts on one
+// of the first few; the caller waits until the last one is done. The
+// count is set before any task is dealt: a worker still draining its
+// queues from the last run may take one of these tasks straight away.
+void ThreadPool::run(const vector<Task>& tasks) {
+    if (tasks.empty()) return;
+
+    unique_lock<mutex> guard(lock);
+    pending = tasks.size();
+    generation++;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        Queue& queue = *queues[i % queues.size()];
+        lock_guard<mutex> queueGuard(queue.lock);
+        queue.tasks.push_front(&tasks[i]);
+    }
+    wake.notify_all();
+    done.wait(guard, [this] { return pending == 0; });
+}
+
+void ThreadPool::workerLoop(int index) {
+    unsigned long long seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> guard(lock);
+            wake.wait(guard, [this, seen] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        while (const Task* task = takeTask(index)) {
+            (*task)(index);
+            lock_guard<mutex> guard(lock);
+            if (--pending == 0) done.notify_all();
+        }
+    }
+}
+
+// The earliest task dealt to this worker, or failing that the latest one
+// dealt to the next worker that still has any
+const ThreadPool::Task* ThreadPool::takeTask(int index) {
+    int count = static_cast<int>(queues.size());
+    for (int i = 0; i < count; i++) {
+        Queue& queue = *queues[(index + i) % count];
+        lock_guard<mutex> guard(queue.lock);
+        if (queue.tasks.empty()) continue;
+
+        const Task* task;
+        if (i == 0) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        } else {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        return task;
+    }
+    return nullptr;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task queue. A worker
+// takes tasks from the back of its own queue and, once that is empty,
+// steals from the front of the others, so uneven tasks still keep every
+// thread busy.
+class ThreadPool {
+public:
+    // A task is told which worker runs it, so it can use per-worker state
+    typedef std::function<void(int worker)> Task;
+
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    int size() const { return static_cast<int>(workers.size()); }
+
+    // Run every task and return once all of them have finished
+    void run(const std::vector<Task>& tasks);
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<const Task*> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue> > queues;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    unsigned long long generation;
+    size_t pending;
+    bool stopping;
+
+    void workerLoop(int index);
+    const Task* takeTask(int index);
+};
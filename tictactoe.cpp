@@ -0,0 +1,188 @@
+#include "tictactoe.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Search state of the calling thread, per board variant and side to move
+typedef map<pair<const BoardGeometry*, char>, unique_ptr<AIPlayer> > PlayerCache;
+
+// Each new AIPlayer gets its own random sequence
+atomic<uint64_t> nextSeed(0x9E3779B97F4A7C15ULL);
+
+PlayerCache& threadPlayers() {
+    thread_local PlayerCache players;
+    return players;
+}
+
+// One bestMoveAsync call waiting for a search thread
+struct AsyncRequest {
+    Position position;
+    MoveOptions options;
+    shared_ptr<StopSignal> signal;
+    promise<AIMove> reply;
+};
+
+// Long-lived threads running bestMoveAsync calls in the order they come,
+// so the search caches each one builds up outlast a single call
+class AsyncSearchThreads {
+public:
+    AsyncSearchThreads() : stopping(false) {
+        unsigned count = max(1u, thread::hardware_concurrency());
+        for (unsigned i = 0; i < count; i++) {
+            threads.push_back(thread(&AsyncSearchThreads::run, this));
+        }
+    }
+
+    ~AsyncSearchThreads() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+            for (size_t i = 0; i < queue.size(); i++) {
+                queue[i].signal->stopped = true;
+            }
+            for (size_t i = 0; i < running.size(); i++) {
+                running[i]->stopped = true;
+            }
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i].join();
+        }
+    }
+
+    void submit(AsyncRequest request) {
+        {
+            lock_guard<mutex> guard(lock);
+            queue.push_back(move(request));
+        }
+        wake.notify_one();
+    }
+
+private:
+    mutex lock;
+    condition_variable wake;
+    deque<AsyncRequest> queue;
+    vector<shared_ptr<StopSignal> > running;
+    vector<thread> threads;
+    bool stopping;
+
+    void run() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            AsyncRequest request = move(queue.front());
+            queue.pop_front();
+            running.push_back(request.signal);
+            guard.unlock();
+            request.options.settings.stop = request.signal.get();
+            request.reply.set_value(bestMove(request.position, request.options));
+            guard.lock();
+            running.erase(find(running.begin(), running.end(), request.signal));
+        }
+    }
+};
+
+AsyncSearchThreads& asyncThreads() {
+    static AsyncSearchThreads threads;
+    return threads;
+}
+
+}
+
+Position::Position() : shape(&BoardGeometry::get(3, 3)), toMove('X') {
+}
+
+Position::Position(int size, int winLength, char firstPlayer)
+    : shape(&BoardGeometry::get(size, winLength)), toMove(firstPlayer) {
+}
+
+Position::Position(const BoardGeometry& geometry, char firstPlayer) : shape(&geometry), toMove(firstPlayer) {
+}
+
+bool Position::isLegal(int cell) const {
+    return cell >= 0 && cell < shape->cellTotal && cells.isEmpty(cell) && !isOver();
+}
+
+Position Position::play(int cell) const {
+    Position next = *this;
+    next.cells.place(cell, toMove);
+    next.toMove = toMove == 'X' ? 'O' : 'X';
+    return next;
+}
+
+char Position::winner() const {
+    if (shape->hasWin(cells.x)) return 'X';
+    if (shape->hasWin(cells.o)) return 'O';
+    return ' ';
+}
+
+bool Position::isOver() const {
+    return winner() != ' ' || cells.occupied() == shape->full;
+}
+
+AIMove bestMove(const Position& position, const MoveOptions& options) {
+    const BoardGeometry& shape = position.geometry();
+    unique_ptr<AIPlayer>& player = threadPlayers()[make_pair(&shape, position.toMove)];
+    if (!player) {
+        player.reset(new AIPlayer(shape, nextSeed.fetch_add(0x9E3779B97F4A7C15ULL)));
+    }
+    if (options.seed != 0) {
+        player->reseed(options.seed);
+    }
+    return player->chooseMove(position.cells, position.toMove, options.difficulty, options.settings);
+}
+
+void clearSearchCache() {
+    threadPlayers().clear();
+}
+
+bool MoveFuture::ready() const {
+    return result.wait_for(chrono::seconds(0)) == future_status::ready;
+}
+
+bool MoveFuture::waitFor(int milliseconds) const {
+    return result.wait_for(chrono::milliseconds(milliseconds)) == future_status::ready;
+}
+
+AIMove MoveFuture::get() {
+    return result.get();
+}
+
+void MoveFuture::cancel() {
+    if (signal) {
+        signal->stopped = true;
+    }
+}
+
+shared_ptr<StopSignal> stopSignalAfter(int milliseconds) {
+    shared_ptr<StopSignal> signal = make_shared<StopSignal>();
+    if (milliseconds > 0) {
+        signal->deadline = chrono::steady_clock::now() + chrono::milliseconds(milliseconds);
+    }
+    return signal;
+}
+
+MoveFuture bestMoveAsync(const Position& position, const MoveOptions& options, int deadlineMs) {
+    AsyncRequest request;
+    request.position = position;
+    request.options = options;
+    request.signal = stopSignalAfter(deadlineMs);
+    future<AIMove> result = request.reply.get_future();
+    shared_ptr<StopSignal> signal = request.signal;
+    asyncThreads().submit(move(request));
+    return MoveFuture(move(result), signal);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+// Public interface of the engine library (libtictactoe). It does no
+// console or file I/O, and every function here may be called from any
+// number of threads at once.
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include "ai_player.h"
+#include "engine.h"
+
+// A position of any board variant, with the side to move. It is a plain
+// value: playing a move returns a new position.
+struct Position {
+    const BoardGeometry* shape;     // shared, never changes
+    GridPosition cells;
+    char toMove;
+
+    // Empty classic 3x3 board, X to move
+    Position();
+    // Empty N x N board needing K in a row
+    Position(int size, int winLength, char firstPlayer = 'X');
+    // Empty board of any variant, including the 4x4x4 cube
+    explicit Position(const BoardGeometry& geometry, char firstPlayer = 'X');
+
+    const BoardGeometry& geometry() const { return *shape; }
+    bool isLegal(int cell) const;
+    // The position after the side to move plays `cell`
+    Position play(int cell) const;
+    // 'X' or 'O' once a side has a line, ' ' otherwise
+    char winner() const;
+    bool isOver() const;
+};
+
+// What to ask the AI for
+struct MoveOptions {
+    Difficulty difficulty;
+    AISettings settings;
+    uint64_t seed;              // non-zero: reseed the random choices of this call
+
+    MoveOptions() : difficulty(Difficulty::HARD), seed(0) {}
+};
+
+// The AI's move for the side to move. Search state (transposition tables,
+// Monte Carlo trees) is cached per calling thread, board variant and side,
+// so repeated calls on one thread get faster and concurrent calls share
+// nothing. Returns cell -1 when the game is already over.
+AIMove bestMove(const Position& position, const MoveOptions& options = MoveOptions());
+
+// Drop the calling thread's cached search state
+void clearSearchCache();
+
+// The AI's move being worked out on another thread. The search answers by
+// its deadline whatever it is doing then, with the best move it has found
+// so far, and cancel() makes it answer the same way at once.
+class MoveFuture {
+public:
+    MoveFuture() {}
+    MoveFuture(std::future<AIMove> result, std::shared_ptr<StopSignal> signal)
+        : result(std::move(result)), signal(std::move(signal)) {}
+
+    bool valid() const { return result.valid(); }
+    // The move can be taken without waiting
+    bool ready() const;
+    // Wait up to `milliseconds`; true if the move is ready
+    bool waitFor(int milliseconds) const;
+    // Wait for the move and take it; only once
+    AIMove get();
+    // Ask the search to stop now
+    void cancel();
+
+private:
+    std::future<AIMove> result;
+    std::shared_ptr<StopSignal> signal;
+};
+
+// bestMove on one of the library's search threads (one per core, kept
+// for the life of the process), stopping `deadlineMs` from now at the
+// latest; 0 for no deadline beyond the usual time budget. Calls spread over
+// the threads, so each thread's cached search state is reused less than
+// with repeated bestMove calls on one thread.
+MoveFuture bestMoveAsync(const Position& position, const MoveOptions& options, int deadlineMs = 0);
+
+// A hard deadline `milliseconds` from now, or none for 0
+std::shared_ptr<StopSignal> stopSignalAfter(int milliseconds);
@@ -0,0 +1,323 @@
+#include "trainer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "bitboard.h"
+#include "perfect_play.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace {
+
+const int CELLS = PolicyTable::CELLS;
+const int ENTRIES = PolicyTable::STATES * PolicyTable::CELLS;
+
+// Updates made by one worker in one round
+struct WorkerTally {
+    double change;
+    long long updates;
+
+    WorkerTally() : change(0), updates(0) {}
+};
+
+// splitmix64, so each worker's games depend only on the seed, round and worker
+uint64_t mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// xorshift64, uniform in [0, bound)
+int nextRandom(uint64_t& random, int bound) {
+    random ^= random << 13;
+    random ^= random >> 7;
+    random ^= random << 17;
+    return static_cast<int>(random % static_cast<uint64_t>(bound));
+}
+
+// Highest value among the empty cells of a state, and the first cell
+// in row-major order that has it
+float bestValue(const atomic<float>* values, int state, BoardMask empty, int& cell) {
+    const atomic<float>* row = values + state * CELLS;
+    float best = -2;
+    cell = -1;
+    for (BoardMask rest = empty; rest; rest &= rest - 1) {
+        int candidate = lowestCell(rest);
+        float value = row[candidate].load(memory_order_relaxed);
+        if (value > best) {
+            best = value;
+            cell = candidate;
+        }
+    }
+    return best;
+}
+
+// One game from the empty board, both sides learning into the shared values
+void playGame(const TrainOptions& options, atomic<float>* values, uint64_t& random, WorkerTally& tally) {
+    BoardMask own = 0;
+    BoardMask opponent = 0;
+    int explore = static_cast<int>(options.exploration * 65536);
+
+    while (true) {
+        BoardMask empty = static_cast<BoardMask>(FULL_BOARD & ~(own | opponent));
+        int state = PolicyTable::stateIndex(own, opponent);
+        int cell;
+        bestValue(values, state, empty, cell);
+        if (nextRandom(random, 65536) < explore) {
+            int skip = nextRandom(random, cellCount(empty));
+            for (int i = 0; i < skip; i++) {
+                empty &= empty - 1;
+            }
+            cell = lowestCell(empty);
+        }
+
+        BoardMask played = static_cast<BoardMask>(own | 1 << cell);
+        bool over = true;
+        float target = 0;
+        if (hasWinLine(played)) {
+            target = 1;
+        } else if ((played | opponent) != FULL_BOARD) {
+            int reply;
+            BoardMask left = static_cast<BoardMask>(FULL_BOARD & ~(played | opponent));
+            float answer = bestValue(values, PolicyTable::stateIndex(opponent, played), left, reply);
+            target = static_cast<float>(-options.discount * answer);
+            over = false;
+        }
+
+        atomic<float>& entry = values[state * CELLS + cell];
+        float old = entry.load(memory_order_relaxed);
+        float change = static_cast<float>(options.learningRate * (target - old));
+        entry.store(old + change, memory_order_relaxed);
+        tally.change += fabs(change);
+        tally.updates++;
+
+        if (over) {
+            return;
+        }
+        own = opponent;
+        opponent = played;
+    }
+}
+
+// Scale the learned values into the table
+void quantize(const atomic<float>* values, PolicyTable& table) {
+    table.reset();
+    for (int state = 0; state < PolicyTable::STATES; state++) {
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (table.value(state, cell) == PolicyTable::ILLEGAL) continue;
+            float value = values[state * CELLS + cell].load(memory_order_relaxed);
+            table.setValue(state, cell, static_cast<int>(lround(value * 127)));
+        }
+    }
+}
+
+// Perfect-play score of a position for the side to move: positive wins
+int perfectScore(BoardMask own, BoardMask opponent) {
+    Bitboard board;
+    board.x = opponent;
+    board.o = own;
+    return perfectPlay(board, true).score;
+}
+
+int sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+// Walk every position reachable from the empty board once, counting those
+// still in play and those where the table's best move keeps the result
+void countAgreement(const PolicyTable& table, BoardMask own, BoardMask opponent, vector<bool>& seen,
+                    int& positions, int& agreeing) {
+    int state = PolicyTable::stateIndex(own, opponent);
+    if (seen[state] || hasWinLine(opponent) || (own | opponent) == FULL_BOARD) {
+        return;
+    }
+    seen[state] = true;
+    positions++;
+
+    int cell = table.chooseMove(own, opponent, 100, 0);
+    BoardMask played = static_cast<BoardMask>(own | 1 << cell);
+    if (sign(-perfectScore(opponent, played)) == sign(perfectScore(own, opponent))) {
+        agreeing++;
+    }
+
+    for (BoardMask empty = static_cast<BoardMask>(FULL_BOARD & ~(own | opponent)); empty; empty &= empty - 1) {
+        BoardMask child = static_cast<BoardMask>(own | 1 << lowestCell(empty));
+        countAgreement(table, opponent, child, seen, positions, agreeing);
+    }
+}
+
+void printUsage() {
+    cout << "Usage: TicTacToe_Project --train [options]\n"
+         << "  --games N         self-play games to learn from (default 2000000)\n"
+         << "  --workers N       threads playing games (default: one per core)\n"
+         << "  --rounds N        progress reports along the way (default 10)\n"
+         << "  --rate R          learning rate (default 0.3)\n"
+         << "  --discount D      value kept per ply, so quicker wins count more (default 0.9)\n"
+         << "  --explore E       chance of a random move (default 0.5)\n"
+         << "  --seed N          seed for the random moves (default 1)\n"
+         << "  --output FILE     table to write (default " << MEDIUM_POLICY_FILE << ")\n";
+}
+
+}
+
+TrainOptions::TrainOptions()
+    : games(2000000), workers(max(1, static_cast<int>(thread::hardware_concurrency()))), rounds(10),
+      learningRate(0.3), discount(0.9), exploration(0.5), seed(1), outputFile(MEDIUM_POLICY_FILE) {
+}
+
+void trainPolicy(const TrainOptions& options, PolicyTable& table,
+                 const function<void(const TrainRound&)>& progress) {
+    int workers = max(1, options.workers);
+    int rounds = max(1, options.rounds);
+    unique_ptr<atomic<float>[]> values(new atomic<float>[ENTRIES]);
+    for (int i = 0; i < ENTRIES; i++) {
+        values[i].store(0, memory_order_relaxed);
+    }
+
+    ThreadPool pool(workers);
+    long long played = 0;
+    for (int round = 0; round < rounds; round++) {
+        long long games = options.games / rounds + (round < options.games % rounds ? 1 : 0);
+        vector<WorkerTally> tallies(workers);
+
+        // Worker w plays every workers-th game of the round with its own generator
+        vector<ThreadPool::Task> tasks;
+        for (int w = 0; w < workers; w++) {
+            tasks.push_back([&, w, round, games](int) {
+                uint64_t random = mix(options.seed ^ mix(static_cast<uint64_t>(round) * workers + w)) | 1;
+                WorkerTally tally;
+                for (long long number = w; number < games; number += workers) {
+                    playGame(options, values.get(), random, tally);
+                }
+                tallies[w] = tally;
+            });
+        }
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        pool.run(tasks);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        played += games;
+
+        quantize(values.get(), table);
+        if (progress) {
+            WorkerTally total;
+            for (int w = 0; w < workers; w++) {
+                total.change += tallies[w].change;
+                total.updates += tallies[w].updates;
+            }
+            TrainRound report;
+            report.round = round + 1;
+            report.games = played;
+            report.seconds = elapsed.count();
+            report.gamesPerSecond = games / max(elapsed.count(), 1e-9);
+            report.meanChange = total.updates > 0 ? total.change / total.updates : 0;
+            report.agreement = policyAgreement(table);
+            progress(report);
+        }
+    }
+    quantize(values.get(), table);
+}
+
+double policyAgreement(const PolicyTable& table) {
+    vector<bool> seen(PolicyTable::STATES, false);
+    int positions = 0;
+    int agreeing = 0;
+    countAgreement(table, 0, 0, seen, positions, agreeing);
+    return positions > 0 ? static_cast<double>(agreeing) / positions : 0;
+}
+
+bool loadPolicyTable(const string& path, PolicyTable& table) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    vector<uint8_t> bytes(PolicyTable::HEADER_BYTES + ENTRIES + 1);
+    size_t got = fread(&bytes[0], 1, bytes.size(), file);
+    fclose(file);
+    bytes.resize(got);
+    return table.decode(bytes);
+}
+
+bool savePolicyTable(const string& path, const PolicyTable& table) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    vector<uint8_t> bytes = table.encode();
+    bool written = fwrite(&bytes[0], 1, bytes.size(), file) == bytes.size();
+    return fclose(file) == 0 && written;
+}
+
+int trainMain(int argc, char* argv[]) {
+    TrainOptions options;
+
+    for (int i = 0; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--help") {
+            printUsage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            cout << "Missing value for " << flag << "\n";
+            printUsage();
+            return 1;
+        }
+        string value = argv[++i];
+        bool valid = true;
+        if (flag == "--games") options.games = atoll(value.c_str());
+        else if (flag == "--workers") options.workers = atoi(value.c_str());
+        else if (flag == "--rounds") options.rounds = atoi(value.c_str());
+        else if (flag == "--rate") options.learningRate = atof(value.c_str());
+        else if (flag == "--discount") options.discount = atof(value.c_str());
+        else if (flag == "--explore") options.exploration = atof(value.c_str());
+        else if (flag == "--seed") options.seed = strtoull(value.c_str(), nullptr, 10);
+        else if (flag == "--output") options.outputFile = value;
+        else valid = false;
+
+        if (!valid) {
+            cout << "Invalid option: " << flag << " " << value << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (options.games < 1 || options.rounds < 1 || options.workers < 1 ||
+        !(options.learningRate > 0 && options.learningRate <= 1) ||
+        !(options.discount > 0 && options.discount <= 1) ||
+        !(options.exploration >= 0 && options.exploration <= 1)) {
+        cout << "Invalid game count, round count, worker count, rate, discount or exploration\n";
+        return 1;
+    }
+
+    cout << "Training: " << options.games << " self-play games on 3x3, " << options.workers
+         << " workers, rate " << options.learningRate << ", discount " << options.discount
+         << ", exploration " << options.exploration << "\n";
+
+    double seconds = 0;
+    PolicyTable table;
+    trainPolicy(options, table, [&](const TrainRound& round) {
+        seconds += round.seconds;
+        cout << fixed << setprecision(1)
+             << "Round " << round.round << "/" << options.rounds << ": " << round.games << " games, "
+             << round.gamesPerSecond << " games/s, mean change " << scientific << setprecision(2) << round.meanChange
+             << fixed << ", perfect-play agreement " << setprecision(2) << 100.0 * round.agreement << "%\n";
+    });
+
+    if (!savePolicyTable(options.outputFile, table)) {
+        cout << "Could not write " << options.outputFile << "\n";
+        return 1;
+    }
+    cout << fixed << setprecision(1) << "Time: " << seconds << " s, " << options.games / seconds << " games/s\n"
+         << "Wrote " << options.outputFile << " (" << table.encode().size() << " bytes)\n";
+    return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "policy_table.h"
+
+const char MEDIUM_POLICY_FILE[] = "medium_policy.dat";
+
+// Settings for learning the Medium policy by self-play on 3x3
+struct TrainOptions {
+    long long games;
+    int workers;                // threads playing games, all updating one table
+    int rounds;                 // the games are split into rounds, each reported
+    double learningRate;
+    double discount;            // per ply, so quicker wins are worth more
+    double exploration;         // chance of a random move instead of the best
+    uint64_t seed;
+    std::string outputFile;
+
+    TrainOptions();
+};
+
+// Progress after one round
+struct TrainRound {
+    int round;
+    long long games;            // played so far
+    double seconds;             // this round
+    double gamesPerSecond;      // this round
+    double meanChange;          // mean size of one value update this round
+    double agreement;           // share of positions where the best value is a perfect-play move
+};
+
+// Tabular Q-learning in negamax form. Each move updates its value toward
+// the reward when the game ends (1 for a win, 0 for a draw), otherwise
+// toward minus the discounted best value the opponent has in the next
+// position. The workers update one shared table without locks, in the
+// Hogwild style: two updates to the same entry at once can lose one of
+// them, which the next visit makes up for. With one worker the table
+// depends only on the seed.
+//
+// `table` comes back with the values scaled to -127..127. `progress`, if
+// given, is called after every round.
+void trainPolicy(const TrainOptions& options, PolicyTable& table,
+                 const std::function<void(const TrainRound&)>& progress = nullptr);
+
+// Share of the positions reachable in a game where the table's best move
+// keeps the perfect-play result (win, draw or loss)
+double policyAgreement(const PolicyTable& table);
+
+// Read or write a table file; false if it cannot be read or is not a table
+bool loadPolicyTable(const std::string& path, PolicyTable& table);
+bool savePolicyTable(const std::string& path, const PolicyTable& table);
+
+// Entry point for --train: reads the options that follow it, trains and
+// writes the table. Returns the process exit code.
+int trainMain(int argc, char* argv[]);
@@ -0,0 +1,93 @@
+#include "transposition.h"
+
+namespace {
+
+const int SYMMETRY_COUNT = 8;
+
+// Lookup tables shared by every table instance, built once at startup
+struct SymmetryTables {
+    // Mask after applying each rotation/reflection
+    BoardMask image[SYMMETRY_COUNT][FULL_BOARD + 1];
+    // Sum of 3^cell over the set bits of a mask
+    uint16_t base3[FULL_BOARD + 1];
+
+    SymmetryTables() {
+        // Cell each cell moves to under the symmetry: identity, three
+        // rotations, then mirror, both diagonals and the vertical flip
+        static const int CELL_MAP[SYMMETRY_COUNT][9] = {
+            {0, 1, 2, 3, 4, 5, 6, 7, 8},
+            {2, 5, 8, 1, 4, 7, 0, 3, 6},
+            {8, 7, 6, 5, 4, 3, 2, 1, 0},
+            {6, 3, 0, 7, 4, 1, 8, 5, 2},
+            {2, 1, 0, 5, 4, 3, 8, 7, 6},
+            {0, 3, 6, 1, 4, 7, 2, 5, 8},
+            {8, 5, 2, 7, 4, 1, 6, 3, 0},
+            {6, 7, 8, 3, 4, 5, 0, 1, 2}
+        };
+
+        for (int mask = 0; mask <= FULL_BOARD; mask++) {
+            uint16_t code = 0;
+            uint16_t power = 1;
+            for (int cell = 0; cell < 9; cell++) {
+                if (mask >> cell & 1) code += power;
+                power *= 3;
+            }
+            base3[mask] = code;
+
+            for (int s = 0; s < SYMMETRY_COUNT; s++) {
+                BoardMask mapped = 0;
+                for (int cell = 0; cell < 9; cell++) {
+                    if (mask >> cell & 1) mapped |= 1 << CELL_MAP[s][cell];
+                }
+                image[s][mask] = mapped;
+            }
+        }
+    }
+};
+
+const SymmetryTables& symmetryTables() {
+    static const SymmetryTables tables;
+    return tables;
+}
+
+}
+
+TranspositionTable::TranspositionTable()
+    : entries(POSITION_KEY_COUNT, Entry{0, ScoreBound::NONE}), probeCount(0), hitCount(0) {}
+
+PositionKey TranspositionTable::canonicalKey(const Bitboard& board, bool oToMove) {
+    const SymmetryTables& t = symmetryTables();
+    int best = POSITION_KEY_COUNT;
+    for (int s = 0; s < SYMMETRY_COUNT; s++) {
+        int code = t.base3[t.image[s][board.x]] + 2 * t.base3[t.image[s][board.o]];
+        if (code < best) best = code;
+    }
+    return static_cast<PositionKey>(best * 2 + (oToMove ? 1 : 0));
+}
+
+bool TranspositionTable::probe(PositionKey key, int& score, ScoreBound& bound) {
+    probeCount++;
+    const Entry& entry = entries[key];
+    if (entry.bound == ScoreBound::NONE) {
+        return false;
+    }
+    hitCount++;
+    score = entry.score;
+    bound = entry.bound;
+    return true;
+}
+
+void TranspositionTable::store(PositionKey key, int score, ScoreBound bound) {
+    entries[key].score = static_cast<int8_t>(score);
+    entries[key].bound = bound;
+}
+
+void TranspositionTable::clear() {
+    entries.assign(POSITION_KEY_COUNT, Entry{0, ScoreBound::NONE});
+    probeCount = 0;
+    hitCount = 0;
+}
+
+double TranspositionTable::hitRate() const {
+    return probeCount > 0 ? hitCount * 100.0 / probeCount : 0.0;
+}
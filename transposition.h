@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+
+// Position key: base-3 encoding of the board (0 empty, 1 X, 2 O per cell)
+// times two plus the side to move. Every 3x3 position fits below 39366.
+typedef uint16_t PositionKey;
+
+const int POSITION_KEY_COUNT = 19683 * 2;
+
+// How a stored score relates to the true minimax value. Alpha-beta cutoffs
+// only prove that the value is at least (LOWER) or at most (UPPER) the score.
+enum class ScoreBound : uint8_t { NONE, EXACT, LOWER, UPPER };
+
+// Remembers minimax scores between searches, turns and games.
+// Positions are canonicalized over the 8 rotations and reflections of the
+// board, so symmetric positions share a single entry.
+class TranspositionTable {
+private:
+    struct Entry {
+        int8_t score;
+        ScoreBound bound;
+    };
+    
+    std::vector<Entry> entries;
+    unsigned long long probeCount;
+    unsigned long long hitCount;
+
+public:
+    TranspositionTable();
+
+    // Smallest key among the 8 symmetric images of the position
+    static PositionKey canonicalKey(const Bitboard& board, bool oToMove);
+
+    // Look up a score stored relative to the position itself (depth 0)
+    bool probe(PositionKey key, int& score, ScoreBound& bound);
+    void store(PositionKey key, int score, ScoreBound bound);
+    void clear();
+
+    unsigned long long probes() const { return probeCount; }
+    unsigned long long hits() const { return hitCount; }
+    double hitRate() const;
+};
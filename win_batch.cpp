@@ -0,0 +1,157 @@
+#include "win_batch.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WIN_BATCH_X86 1
+#endif
+
+using namespace std;
+
+static_assert(sizeof(GridPosition) == 16, "the vector kernels load a board as two packed 64-bit masks");
+
+namespace {
+
+// Indexed by X won | O won << 1 | full << 2, so packing the vector
+// results needs no branches
+const BoardStatus STATUS[8] = {
+    BoardStatus::ONGOING, BoardStatus::X_WON, BoardStatus::O_WON, BoardStatus::X_WON,
+    BoardStatus::DRAW, BoardStatus::X_WON, BoardStatus::O_WON, BoardStatus::X_WON
+};
+
+inline BoardStatus statusOf(int xWon, int oWon, int full) {
+    return STATUS[xWon | oWon << 1 | full << 2];
+}
+
+void classifyScalar(const BoardGeometry& geometry, const GridPosition* boards, size_t count,
+                    BoardStatus* statuses) {
+    for (size_t i = 0; i < count; i++) {
+        const GridPosition& board = boards[i];
+        statuses[i] = statusOf(geometry.hasWin(board.x), geometry.hasWin(board.o),
+                               board.occupied() == geometry.full);
+    }
+}
+
+#ifdef WIN_BATCH_X86
+
+// One board per register, X in the low lane and O in the high one. SSE2
+// has no 64-bit compare, so a lane is complete when both of its 32-bit
+// halves of `line & ~pieces` are zero.
+__attribute__((target("sse2")))
+void classifySse2(const BoardGeometry& geometry, const GridPosition* boards, size_t count,
+                  BoardStatus* statuses) {
+    const GridMask* lines = geometry.lines.data();
+    size_t lineCount = geometry.lines.size();
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(boards + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(boards + i + 1));
+        __m128i wonA = zero;
+        __m128i wonB = zero;
+        for (size_t l = 0; l < lineCount; l++) {
+            __m128i line = _mm_set1_epi64x(static_cast<long long>(lines[l]));
+            __m128i missingA = _mm_cmpeq_epi32(_mm_andnot_si128(a, line), zero);
+            __m128i missingB = _mm_cmpeq_epi32(_mm_andnot_si128(b, line), zero);
+            wonA = _mm_or_si128(wonA, _mm_and_si128(missingA, _mm_shuffle_epi32(missingA, 0xB1)));
+            wonB = _mm_or_si128(wonB, _mm_and_si128(missingB, _mm_shuffle_epi32(missingB, 0xB1)));
+        }
+        int maskA = _mm_movemask_pd(_mm_castsi128_pd(wonA));
+        int maskB = _mm_movemask_pd(_mm_castsi128_pd(wonB));
+        const GridPosition& boardA = boards[i];
+        const GridPosition& boardB = boards[i + 1];
+        statuses[i] = STATUS[maskA | (boardA.occupied() == geometry.full) << 2];
+        statuses[i + 1] = STATUS[maskB | (boardB.occupied() == geometry.full) << 2];
+    }
+    classifyScalar(geometry, boards + i, count - i, statuses + i);
+}
+
+// Two boards per register as X, O, X, O lanes, and two registers per step
+__attribute__((target("avx2")))
+void classifyAvx2(const BoardGeometry& geometry, const GridPosition* boards, size_t count,
+                  BoardStatus* statuses) {
+    const GridMask* lines = geometry.lines.data();
+    size_t lineCount = geometry.lines.size();
+    const __m256i full = _mm256_set1_epi64x(static_cast<long long>(geometry.full));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(boards + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(boards + i + 2));
+        __m256i wonA = _mm256_setzero_si256();
+        __m256i wonB = _mm256_setzero_si256();
+        for (size_t l = 0; l < lineCount; l++) {
+            __m256i line = _mm256_set1_epi64x(static_cast<long long>(lines[l]));
+            wonA = _mm256_or_si256(wonA, _mm256_cmpeq_epi64(_mm256_and_si256(a, line), line));
+            wonB = _mm256_or_si256(wonB, _mm256_cmpeq_epi64(_mm256_and_si256(b, line), line));
+        }
+        // x | o lands in both lanes of each board
+        __m256i occupiedA = _mm256_or_si256(a, _mm256_shuffle_epi32(a, 0x4E));
+        __m256i occupiedB = _mm256_or_si256(b, _mm256_shuffle_epi32(b, 0x4E));
+        int won = _mm256_movemask_pd(_mm256_castsi256_pd(wonA)) |
+                  _mm256_movemask_pd(_mm256_castsi256_pd(wonB)) << 4;
+        int filled = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(occupiedA, full))) |
+                     _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(occupiedB, full))) << 4;
+        for (int k = 0; k < 4; k++) {
+            statuses[i + k] = STATUS[(won >> (2 * k) & 3) | (filled >> (2 * k) & 1) << 2];
+        }
+    }
+    classifyScalar(geometry, boards + i, count - i, statuses + i);
+}
+
+#endif
+
+}
+
+bool batchKernelSupported(BatchKernel kernel) {
+    switch (kernel) {
+        case BatchKernel::SCALAR:
+            return true;
+#ifdef WIN_BATCH_X86
+        case BatchKernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case BatchKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+BatchKernel bestBatchKernel() {
+    static const BatchKernel best = batchKernelSupported(BatchKernel::AVX2) ? BatchKernel::AVX2
+                                  : batchKernelSupported(BatchKernel::SSE2) ? BatchKernel::SSE2
+                                  : BatchKernel::SCALAR;
+    return best;
+}
+
+const char* batchKernelName(BatchKernel kernel) {
+    switch (kernel) {
+        case BatchKernel::SCALAR: return "scalar";
+        case BatchKernel::SSE2: return "sse2";
+        case BatchKernel::AVX2: return "avx2";
+    }
+    return "?";
+}
+
+void classifyBoards(const BoardGeometry& geometry, const GridPosition* boards, size_t count,
+                    BoardStatus* statuses) {
+    classifyBoards(geometry, boards, count, statuses, bestBatchKernel());
+}
+
+void classifyBoards(const BoardGeometry& geometry, const GridPosition* boards, size_t count,
+                    BoardStatus* statuses, BatchKernel kernel) {
+    if (!batchKernelSupported(kernel)) {
+        kernel = BatchKernel::SCALAR;
+    }
+    switch (kernel) {
+#ifdef WIN_BATCH_X86
+        case BatchKernel::SSE2:
+            classifySse2(geometry, boards, count, statuses);
+            return;
+        case BatchKernel::AVX2:
+            classifyAvx2(geometry, boards, count, statuses);
+            return;
+#endif
+        default:
+            classifyScalar(geometry, boards, count, statuses);
+            return;
+    }
+}
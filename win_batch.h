@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "engine.h"
+
+// What a board shows, judged the way Game::checkWin and checkDraw do:
+// a line for X first, then a line for O, then a full board
+enum class BoardStatus : uint8_t { ONGOING, X_WON, O_WON, DRAW };
+
+// Ways to classify a batch. The vector kernels test one win line against
+// several boards per instruction: SSE2 one board (both sides) per
+// register, AVX2 two.
+enum class BatchKernel { SCALAR, SSE2, AVX2 };
+
+// Fastest kernel this CPU runs, checked once at run time
+BatchKernel bestBatchKernel();
+bool batchKernelSupported(BatchKernel kernel);
+const char* batchKernelName(BatchKernel kernel);
+
+// Classify `count` boards of one variant, stored back to back as
+// GridPositions, into `statuses`. Every kernel gives the same answer; an
+// unsupported one falls back to the scalar loop.
+void classifyBoards(const BoardGeometry& geometry, const GridPosition* boards, size_t count,
+                    BoardStatus* statuses);
+void classifyBoards(const BoardGeometry& geometry, const GridPosition* boards, size_t count,
+                    BoardStatus* statuses, BatchKernel kernel);